@@ -5,18 +5,125 @@
 #include <string.h>
 #include <math.h>
 #include <limits.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <omp.h>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define X86_KERNELS
+#endif
 
 #define GATHER 1
 #define SCATTER 2
 #define BROADCAST 3
 #define PROCESS 4
+#define REDISTRIBUTE 5
+#define GRID 6
+#define PATHS 7
+#define SERVICE 8
 
 #define TRANSMITTER 0
 
+//l'infini est une grande valeur finie : la somme de deux infinis ne déborde pas, les noyaux n'ont donc
+//ni test ni saturation. Seuls le chargement et l'affichage le convertissent ('i', 0 hors diagonale, LONG_MAX des fichiers binaires)
+#define INF (LONG_MAX / 4)
+//avec des poids négatifs l'infini plus une distance passe sous INF : toute valeur au dela de INF/2 est infinie,
+//chaque produit y ramène ses résultats une fois tous les termes sommés (les distances réelles restent loin de INF/2)
+#define CLAMP(v) ((v) >= INF / 2 ? INF : (v))
+
 #define NEXT(r,p) ((r + 1) + p) % p
 #define PREVIOUS(r,p) ((r - 1) + p) % p
 #define CURRENT(r,p) (r + p) % p
 
+//répartition de n lignes sur p machines sans ajout : la machine r possède les lignes FIRST(r) à FIRST(r+1)-1,
+//les parts diffèrent d'au plus une ligne, MAX_PART est la plus grande et OWNER la machine qui possède la ligne i
+#define FIRST(r,p,n) ((int) ((long) (r) * (n) / (p)))
+#define PART(r,p,n) (FIRST((r) + 1,p,n) - FIRST(r,p,n))
+#define MAX_PART(p,n) (((n) + (p) - 1) / (p))
+#define OWNER(i,p,n) ((int) ((((long) (i) + 1) * (p) - 1) / (n)))
+
+#define ENGINE_RING 1
+#define ENGINE_SQUARE 2
+#define ENGINE_FLOYD 3
+#define ENGINE_NONE 4
+#define ENGINE_SPARSE 5
+#define ENGINE_AUTO 6
+#define ENGINE_SUMMA 7
+#define ENGINE_SHARED 8
+#define SPARSE_DENSITY 0.1
+
+#define DISTRIBUTION_RING 1
+#define DISTRIBUTION_COLLECTIVE 2
+
+#define MAGIC "APSP"
+//octets lus ou écrits au plus par un appel MPI-IO, les comptes de MPI sont des int
+#define IO_CHUNK (1L << 30)
+
+#define COMMAND_INVALID 0
+#define COMMAND_DIST 1
+#define COMMAND_ROW 2
+#define COMMAND_PATH 3
+#define COMMAND_UPDATE 4
+#define COMMAND_RELOAD 5
+#define COMMAND_CHECKPOINT 6
+#define COMMAND_QUIT 7
+#define COMMAND_PATH_LENGTH 256
+
+#define ELEMENT_AUTO 0
+#define ELEMENT_LONG 1
+#define ELEMENT_INT32 2
+#define ELEMENT_UINT16 3
+
+#define GENERATOR_NONE 0
+#define GENERATOR_DENSE 1
+#define GENERATOR_ER 2
+#define GENERATOR_GRID 3
+
+//phases mesurées par le mode benchmark
+#define PHASE_LOAD 0
+#define PHASE_SCATTER 1
+#define PHASE_COMPUTE 2
+#define PHASE_GATHER 3
+#define PHASE_OUTPUT 4
+#define PHASES 5
+
+//événements de la trace, les premiers sont les phases
+#define EVENT_RING_COMPUTE 5
+#define EVENT_RING_WAIT 6
+#define EVENT_REDISTRIBUTE 7
+#define EVENT_RELAY 8
+#define EVENT_DISTRIBUTE 9
+#define EVENT_FLOYD_COMPUTE 10
+#define EVENT_FLOYD_BROADCAST 11
+#define EVENT_DIJKSTRA 12
+#define EVENT_CHECKPOINT 13
+#define EVENT_SUMMA_COMPUTE 14
+#define EVENT_SUMMA_WAIT 15
+#define EVENTS 16
+//au dela de ce nombre d'événements enregistrés une machine ne fait plus que les additionner
+#define TRACE_CAPACITY (1 << 20)
+
+//les noyaux écrits avec les vecteurs de GCC sont compilés pour AVX2 et sans extension, le bon est choisi au lancement
+//ils sont optimisés meme si le reste du programme est compilé sans -O, sinon chaque vecteur repasse par la pile
+#ifdef X86_KERNELS
+#define CLONES __attribute__((target_clones("avx2","default"), optimize("O2")))
+#else
+#define CLONES
+#endif
+
+//taille des tuiles du noyau min-plus : lignes de m1 traitées ensemble et longueur du produit par passe
+#define TILE_ROWS 32
+#define TILE_DEPTH 512
+//coté des tuiles carrées des copies entre une matrice optimisée en ligne et une matrice optimisée en colonne
+#define COPY_TILE 32
+//largeur maximale des bandes de Floyd-Warshall par blocs, sur la grille comme sur une seule machine
+#define FLOYD_BLOCK 64
+//nombre de lignes calculées entre deux vérifications de l'échange en cours dans l'anneau
+#define PROGRESS_ROWS 64
+//mots de 64 bits d'une ligne de n sommets en accessibilité
+#define WORDS(n) (((n) + 63) / 64)
+
 typedef struct Matrix
 {
     long *array;
@@ -25,6 +132,184 @@ typedef struct Matrix
     bool row_opti;
 } Matrix;
 
+//zone mémoire allouée une seule fois et découpée en tampons
+typedef struct Arena
+{
+    long *base;
+    long size;
+    long used;
+} Arena;
+
+//graphe au format CSR, les arcs du sommet v sont les indices offsets[v] à offsets[v+1]-1
+typedef struct Graph
+{
+    int n;              //nombre de sommets
+    long edges;         //nombre d'arcs
+    bool negative;      //vrai si un arc a un poids négatif
+    long *offsets;
+    int *targets;
+    long *weights;
+} Graph;
+
+//élément du tas de Dijkstra
+typedef struct Node
+{
+    long dist;
+    int vertex;
+} Node;
+
+//tampons d'une machine réutilisés à chaque itération
+typedef struct Workspace
+{
+    Arena arena;
+    Matrix *c;          //résultat du produit, échangé avec a à chaque itération
+    Matrix *spare;      //second tampon de b pour l'anneau
+    Matrix *out;        //bloc envoyé par redistribute
+    Matrix *in;         //bloc recu par redistribute
+} Workspace;
+
+//prédécesseurs des blocs a et b, ils suivent le meme parcours que les distances
+typedef struct Paths
+{
+    Matrix *a;          //prédécesseur de chaque colonne sur le chemin depuis chaque ligne de a
+    Matrix *b;          //prédécesseurs des colonnes de b, tournent avec b dans l'anneau
+    Workspace ws;       //tampons des prédécesseurs, memes roles que ceux des distances
+} Paths;
+
+typedef struct Grid
+{
+    MPI_Comm comm;          //communicateur cartesien de toute la grille
+    MPI_Comm row_comm;      //machines de la meme ligne de la grille
+    MPI_Comm column_comm;   //machines de la meme colonne de la grille
+    int rows, columns;      //dimensions de la grille
+    int row, column;        //coordonnées de la machine dans la grille
+} Grid;
+
+//c[r*ldc+j] = min(c[r*ldc+j], min_i a[r*p+i] + b[j*p+i]) avec a optimisée en ligne et b en colonne
+typedef void (*Kernel)(long *a, long *b, long *c, int n, int p, int m, int ldc);
+//c[0..3] = min(c[0..3], min_i a[i] + b[q*ldb+i]) pour 4 colonnes q de b
+typedef void (*Micro)(long *a, long *b, int ldb, int len, long *c);
+
+//4 valeurs traitées ensemble par minplus_path_micro, la seconde version accepte les adresses non alignées
+typedef long vector_long __attribute__((vector_size(32)));
+typedef long unaligned_long __attribute__((vector_size(32), aligned(1), may_alias));
+
+//entete d'un fichier binaire, suivi des N*N valeurs ligne par ligne
+typedef struct Header
+{
+    char magic[4];          //MAGIC
+    int32_t width;          //taille d'une valeur en octets
+    int64_t size;           //nombre de sommets N
+    int64_t infinity;       //valeur représentant l'absence d'arc
+    int64_t reserved;       //itérations déjà calculées d'un checkpoint, 0 pour une matrice ou un résultat
+    int64_t engine;         //moteur qui a écrit le checkpoint, 0 pour une matrice ou un résultat
+    uint64_t checksum;      //somme de controle du graphe dont le checkpoint est issu, 0 pour une matrice ou un résultat
+} Header;
+
+typedef struct Options
+{
+    char *path;
+    int engine;
+    int distribution;
+    int element;
+    char *kernel;
+    char *convert;
+    char *output;
+    bool binary_output;
+    int *queries;           //paires de sommets dont on affiche le chemin
+    int nb_queries;
+    char *updates;          //fichier d'arcs ajoutés ou raccourcis, appliqués après le calcul
+    bool paths;             //suit les prédécesseurs, imposé par -q
+    bool service;           //garde les distances en mémoire et répond aux commandes de l'entrée standard
+    bool hybrid;            //partage les coeurs du noeud entre ses rangs, un rang par socket ou par noeud
+    int generator;          //GENERATOR_*, lance le mode benchmark sur des graphes générés
+    int *sizes;             //nombres de sommets des graphes générés
+    int nb_sizes;
+    int *threads;           //nombres de threads essayés pour chaque taille, celui de OpenMP si vide
+    int nb_threads;
+    long seed;              //graine des graphes générés
+    double density;         //probabilité d'un arc du générateur er
+    char *trace;            //préfixe des fichiers de trace de chaque machine, NULL sans trace
+    char *checkpoint;       //fichier des checkpoints de la boucle des moteurs en anneau, NULL sans checkpoint
+    int every;              //itérations entre deux checkpoints
+    bool restart;           //reprend le calcul au dernier checkpoint si il correspond au graphe
+    char *manifest;         //liste des graphes du mode batch, NULL sans batch
+    bool reachability;      //calcule seulement l'accessibilité, 1 si un chemin existe et 0 sinon
+} Options;
+
+//graphe du manifeste du mode batch, memes longueurs de chemin que les commandes du mode service
+typedef struct Entry
+{
+    char data[COMMAND_PATH_LENGTH];
+    char output[COMMAND_PATH_LENGTH + 4];   //résultat, <data>.out si le manifeste ne le donne pas
+    long bytes;                             //taille du fichier de données, elle croit avec N²
+} Entry;
+
+//commande du mode service, lue par l'emmeteur et transmise telle quelle à toutes les machines
+typedef struct Command
+{
+    int type;                           //COMMAND_*
+    long args[3];                       //sommets et poids
+    char path[COMMAND_PATH_LENGTH];     //fichier de reload et checkpoint
+} Command;
+
+//compteurs de la machine, relevés entre les phases par le mode benchmark
+typedef struct Counters
+{
+    double operations;      //opérations min-plus, chacune une addition et un minimum
+    double bytes;           //octets recus des autres machines ou écrits dans le fichier résultat
+} Counters;
+
+//durée et octets de chaque phase d'une mesure
+typedef struct Phases
+{
+    double start;           //début de la phase en cours
+    double mark;            //octets déjà comptés au début de la phase en cours
+    double time[PHASES];
+    double bytes[PHASES];
+} Phases;
+
+//intervalle de temps enregistré par la trace
+typedef struct Event
+{
+    int type;               //PHASE_* ou EVENT_*
+    double start;           //secondes depuis l'ouverture de la trace
+    double duration;
+    double bytes;           //octets recus ou écrits pendant l'événement
+} Event;
+
+//trace d'une machine, les totaux de chaque type sont toujours tenus meme quand le tableau est plein
+typedef struct Trace
+{
+    bool enabled;
+    Event *events;
+    long count, capacity, dropped;
+    double origin;          //instant commun de l'ouverture sur toutes les machines
+    double phase, mark;     //début et octets déjà comptés de la phase en cours
+    double total[EVENTS];
+    double bytes[EVENTS];
+    long calls[EVENTS];
+} Trace;
+
+//checkpoints asynchrones de la boucle, le dernier checkpoint complet est toujours dans path
+typedef struct Checkpoint
+{
+    char *path;             //dernier checkpoint complet, NULL sans checkpoint
+    char *part;             //checkpoint en cours d'écriture, renommé en path une fois terminé
+    int every;              //itérations entre deux checkpoints
+    int engine;             //moteur de la boucle, une reprise doit utiliser le meme
+    uint64_t checksum;      //somme de controle du graphe de départ, une reprise doit partir du meme
+    bool pending;           //une écriture est en cours
+    MPI_File file;
+    MPI_Request request;
+    long *buffer;           //copie des lignes en cours d'écriture, au format binaire
+    double bytes;           //octets de l'écriture en cours
+} Checkpoint;
+
+Kernel minplus;
+Counters counters;
+Trace trace;
+
 
 //-----------------------------------------------------------------
 //-------------------------DECLARATION-----------------------------
@@ -34,26 +319,170 @@ typedef struct Matrix
 
 //Fonctions de haut niveau
 int broadcast(int data, int transmitter, int rank, int numprocs);                                       //emmet data sur toutes les machines de l'anneau
-Matrix *scatter(Matrix *data, int size, bool row_opti, int transmitter, int rank, int numprocs);        //transmet une part de data à chaque machine de l'anneau
+Matrix *scatter(Matrix *data, int size, bool row_opti, int transmitter, int rank, int numprocs);        //transmet une part de data à chaque machine de l'anneau, data doit etre optimisée en ligne
 Matrix *gather(int transmitter, int rank, int numprocs, Matrix *matrix);                                //transmet chaque part de data à l'emmeteur
-Matrix *process(Matrix *a, Matrix *b, int rank, int numprocs);                                          //retourne la matrice traité
+int broadcast_collective(int data, int transmitter);                                                    //broadcast avec MPI_Bcast
+Matrix *scatter_collective(Matrix *data, int size, bool row_opti, int transmitter, int rank, int numprocs); //scatter avec MPI_Scatterv, data doit etre optimisée en ligne
+Matrix *gather_collective(int transmitter, int rank, int numprocs, Matrix *matrix);                     //gather avec MPI_Gatherv
+void partition(int n, int numprocs, int unit, int *counts, int *displs);                                //tailles et positions des parts de chaque machine en multiples de unit valeurs
+Matrix *process(Matrix *a, Matrix *b, Workspace *ws, Paths *paths, int rank, int numprocs);             //retourne la matrice traité, a est rendue à l'espace de travail, paths peut etre NULL
+Matrix *square(Matrix *a, Matrix *b, Workspace *ws, Paths *paths, Checkpoint *cp, int first, int N, int rank, int numprocs); //eleve la matrice au carré jusqu'a convergence à partir de l'étape first
+void redistribute(Matrix *a, Matrix *b, Workspace *ws, int rank, int numprocs);                         //reconstruit les colonnes b à partir des lignes a de chaque machine
+void update(Matrix *a, Paths *paths, long *row, long u, long v, long w, MPI_Comm comm);             //  //relache les distances réparties en lignes avec le nouvel arc u -> v de poids w
+int apply_updates(Matrix *a, Paths *paths, long *updates, int count, MPI_Comm comm);                    //applique une liste d'arcs et retourne le nombre d'arcs ignorés
+Matrix *solve(Matrix *a, Matrix *b, Workspace *ws, Paths *paths, Options *options, int N, int rank, int numprocs); //calcule les distances des lignes a avec le moteur et le type choisis
+int load_rows(char *path, Matrix **a, Matrix **b, int rank, int numprocs);                              //charge les lignes a et les colonnes b de chaque machine et retourne N
+void serve(Matrix *a, Matrix *b, Workspace *ws, Paths *paths, Options *options, int N, int rank, int numprocs); //répond aux commandes jusqu'à quit, libere ensuite toutes les matrices
+int read_command(Command *command);                                                                     //lit une commande sur l'entrée standard, retourne 1 si elle est invalide
+long *fetch_row(Matrix *a, int i, long *row, int rank, int numprocs);                                   //copie chez l'emmeteur la ligne i de la machine qui la possède
+int hybrid_threads(void);                                                                               //fixe le nombre de threads de chaque rang d'après les rangs de son noeud et le retourne
+int thread_slot(int *places);                                                                       //  //part des lignes du thread d'une région parallele, rangée d'après sa place, places a une case par thread
+
+//Mode benchmark
+void benchmark(Options *options, int rank, int numprocs);                                               //mesure le moteur choisi sur des graphes générés pour chaque taille et nombre de threads
+Matrix *generate_graph(int generator, int N, double density, long seed, long *edges);               //  //génere un graphe de N sommets comme data_generation.py et compte ses arcs
+uint64_t next_random(uint64_t *state);                                                                  //tire un entier de 64 bits et avance l'état
+void lap(Phases *phases, int phase);                                                                    //termine la phase sur toutes les machines et commence la suivante
+
+//Mode batch
+void batch(Options *options, int rank, int numprocs);                                                   //résout chaque graphe du manifeste sur une seule machine, chacune prend le suivant dans une file partagée
+Entry *read_manifest(char *path, int *count);                                                           //lit les graphes du manifeste et les trie du plus gros au plus petit
+int compare_entries(const void *a, const void *b);                                                      //ordre décroissant des tailles de fichier pour qsort
+int solve_graph(Entry *entry, Options *options);                                                        //charge, résout et écrit un graphe sur la machine seule, retourne N ou -1
+
+//Trace
+void open_trace(void);                                                                                  //active la trace à partir d'un instant commun à toutes les machines
+double trace_start(void);                                                                               //retourne l'instant de début d'un événement, 0 sans trace
+void trace_stop(int type, double start, double bytes);                                                  //enregistre l'événement commencé à start
+void trace_phase(int phase);                                                                            //enregistre la phase terminée maintenant et commence la suivante
+void close_trace(char *prefix, int rank, int numprocs);                                                 //écrit la trace de chaque machine et affiche le résumé de toutes chez l'emmeteur
+
+//Checkpoints
+Checkpoint create_checkpoint(Options *options, Matrix *a);                                              //prépare les checkpoints de la boucle, path reste NULL sans -C ou avec les prédécesseurs
+int resume(Checkpoint *cp, Matrix *a, Matrix *b, int engine, int N, int rank, int numprocs);            //remplace a, et b pour square, par le dernier checkpoint et retourne son itération, 0 sans checkpoint de ce graphe et de ce moteur
+uint64_t checksum(Matrix *a, long first, MPI_Comm comm);                                                //  //somme de controle des lignes de toutes les machines de comm, first est l'indice de la premiere ligne de a
+bool checkpoint_due(Checkpoint *cp, int iteration, int last);                                           //vrai si un checkpoint doit etre écrit après cette itération
+void start_checkpoint(Checkpoint *cp, long *rows, int h, int N, int iteration, int rank, int numprocs); //commence l'écriture des lignes sans attendre sa fin, rows peut etre cp->buffer
+void finish_checkpoint(Checkpoint *cp, int rank);                                                       //attend l'écriture en cours et en fait le dernier checkpoint complet
+void free_checkpoint(Checkpoint *cp, int rank);                                                         //termine l'écriture en cours et libere le checkpoint
+
+//Floyd-Warshall par blocs sur une grille 2D
+Grid create_grid(MPI_Comm comm);                                                                        //organise les machines du communicateur en grille cartesienne
+Matrix *scatter_grid(Matrix *data, int N, Grid *grid, int transmitter);                                 //transmet une tuile de data complétée à la taille N à chaque machine de la grille
+Matrix *gather_grid(Matrix *tile, int N, Grid *grid, int transmitter);                                  //assemble les tuiles de chaque machine chez l'emmeteur et retire les ajouts au dela de N
+void fill_tile(Matrix *data, Matrix *tile, int row, int column);                                    //  //rempli la tuile avec la partie de data à l'index donné, les cases hors de data sont infinies
+void floyd(Matrix *tile, int N, Grid *grid);                                                            //applique Floyd-Warshall par blocs sur la matrice répartie
+void floyd_diagonal(Matrix *d);                                                                     //  //applique Floyd-Warshall sur le bloc diagonal
+void floyd_row_panel(Matrix *d, Matrix *r);                                                         //  //met à jour une bande de lignes avec le bloc diagonal
+void floyd_column_panel(Matrix *c, Matrix *d);                                                      //  //met à jour une bande de colonnes avec le bloc diagonal
+void floyd_update(Matrix *t, Matrix *c, Matrix *r);                                                 //  //met à jour une tuile avec les deux bandes
+void floyd_shared(Matrix *m, int element);                                                          //  //applique Floyd-Warshall par blocs sur toute la matrice d'une seule machine, sans message, dans le type choisi
+Matrix *gather_row_tiles(Matrix *tile, int N, Grid *grid);                                              //assemble les tuiles d'une ligne de la grille sur sa premiere colonne
+
+//Produit SUMMA sur la grille 2D
+Matrix *summa_process(Matrix *a, Matrix *b, Matrix *c, Grid *grid);                                     //écrit dans c la tuile de la machine du produit de a et b réparties en tuiles, comme matrix_process
+void summa_panels(Matrix *a, Matrix *b, Matrix *column, Matrix *row, int k, Grid *grid, MPI_Request *requests); //commence la diffusion des bandes k de a et de b sur la ligne et la colonne de la grille
+void summa(Matrix *tile, int N, Grid *grid);                                                            //eleve la matrice répartie au carré jusqu'a convergence, la tuile peut changer de tableau
+
+//Graphes creux en CSR, plus courts chemins depuis chaque source
+Graph *load_graph(char *path);                                                                          //lit un fichier texte directement en CSR, sans matrice dense
+Graph *read_graph(char *path, Header *header, bool binary, int rank, int numprocs);                     //taille et nombre d'arcs sur toutes les machines, les arcs chez l'emmeteur ou partout si binary
+Graph *graph_from_rows(Matrix *a, MPI_Comm comm);                                                       //assemble sur toutes les machines le graphe de leurs lignes
+void broadcast_graph(Graph *g, int transmitter, int rank);                                              //transmet les arcs de l'emmeteur à toutes les machines
+Matrix *graph_matrix(Graph *g);                                                                         //matrice dense du graphe, comme load_matrix
+int select_engine(Graph *g, Options *options);                                                          //choisit le moteur creux si le graphe est assez peu dense
+Matrix *sparse(Graph *g, int rank, int numprocs);                                                   //  //Dijkstra depuis chaque ligne de la machine, retourne ses lignes de distances
+void dijkstra(Graph *g, int source, long *dist, Node *heap);                                            //distances depuis source dans dist, heap peut contenir un élément par arc
+void free_graph(Graph *g);                                                                              //libere le graphe
+
+//Accessibilité en bits, une ligne de N sommets tient dans N/64 mots
+uint64_t *pack_bits(Matrix *m);                                                                     //  //compresse chaque ligne de m en bits, 1 si la case n'est pas infinie
+Matrix *unpack_bits(uint64_t *bits, int h, int N);                                                  //  //décompresse h lignes de bits en 0 et 1
+uint64_t *scatter_bits(Matrix *data, int N, int transmitter, int rank, int numprocs);                   //compresse data chez l'emmeteur et transmet ses lignes à chaque machine avec MPI_Scatterv
+Matrix *gather_bits(uint64_t *rows, int N, int transmitter, int rank, int numprocs);                    //assemble les lignes compressées chez l'emmeteur et les décompresse
+uint64_t *closure(uint64_t *a, int N, int rank, int numprocs);                                          //fermeture transitive des lignes a, a peut etre libérée et remplacée
+void process_bits(uint64_t *a, uint64_t **b, uint64_t *c, uint64_t **spare, int N, int rank, int numprocs); //  //écrit dans c le produit booléen des lignes a par les lignes b qui tournent dans l'anneau
+void or_rows(uint64_t *a, uint64_t *b, int first, int w, uint64_t *c, int words);                       //ajoute à c chaque ligne k de b, numérotée à partir de first, dont le bit k de a vaut 1
+void warshall(uint64_t *rows, int N);                                                               //  //fermeture transitive de toutes les lignes d'une seule machine, sur place
 
 //Matrice manipulation
 Matrix *matrix_process(Matrix *m1, Matrix *m2);                                                     //  //retourne le produit matriciel en remplacant l'opération de multiplication par une addition et l'opération de somme par le minimum 
+Matrix *matrix_process_path(Matrix *m1, Matrix *m2, Matrix *p1, Matrix *p2, int column, Matrix **pred); //retourne le produit et ses prédécesseurs, m2 commence à la colonne column
 void replace(Matrix *a, Matrix *b, int row, int column);                                            //  //remplace a par la matrice b à l'index donné
+void extract(Matrix *a, Matrix *b, int row, int column);                                            //  //rempli b avec la partie de a à l'index donné
+void copy_block(Matrix *src, int row, int column, Matrix *dst, int drow, int dcolumn, int h, int w); //  //copie le bloc h x w de src à l'index donné dans dst à l'index donné, par tuiles si les optimisations diffèrent
+bool equals(Matrix *a, Matrix *b);                                                                      //retourne vrai si les deux matrices ont les memes valeurs
+void clamp(long *values, long count);                                                               //  //ramène à INF chaque valeur au dela de INF/2
+
+//Noyau min-plus
+Kernel select_kernel(char *name);                                                                       //choisit le noyau le plus rapide supporté par le processeur
+void minplus_store(long *a, long *b, long *c, int n, int p, int m, int ldc);                            //écrit le produit dans c sans tenir compte de son contenu
+void minplus_tiles(long *a, long *b, long *c, int n, int p, int m, int ldc, Micro micro);          //  //parcourt le produit par tuiles et appelle le micro noyau
+void minplus_micro(long *a, long *b, int len, long *c);                                                 //produit d'une ligne par une colonne sans vectorisation
+void minplus_scalar(long *a, long *b, long *c, int n, int p, int m, int ldc);                           //noyau sans vectorisation explicite
+void minplus_scalar4(long *a, long *b, int ldb, int len, long *c);                                      //micro noyau sans vectorisation explicite
+void minplus_path(long *a, long *b, long *pa, long *pb, long *c, long *pc, int n, int p, int m, int ldc, int column); // //écrit le produit dans c et le prédécesseur de chaque case dans pc
+void minplus_path_micro(long *a, long *b, int first, int len, long *c, long *arg);                      //minimum d'une ligne par une colonne et le premier indice qui l'atteint
+#ifdef X86_KERNELS
+void minplus_avx2(long *a, long *b, long *c, int n, int p, int m, int ldc);                             //noyau AVX2
+void minplus_avx2_4(long *a, long *b, int ldb, int len, long *c);                                       //micro noyau AVX2
+void minplus_avx512(long *a, long *b, long *c, int n, int p, int m, int ldc);                           //noyau AVX-512
+void minplus_avx512_4(long *a, long *b, int ldb, int len, long *c);                                     //micro noyau AVX-512
+#endif
+
+//Types compacts, chaque type déclare minplus_, pack_, unpack_, process_, redistribute_, compute_, relax_ et floyd_shared_ suivis de son nom
+#define DECLARE_COMPACT(T, NAME) \
+void minplus_micro_##NAME(T *a, T *b, int len, T *c); \
+void minplus_##NAME(T *a, T *b, T *c, int n, int p, int m, int ldc); \
+void minplus_store_##NAME(T *a, T *b, T *c, int n, int p, int m, int ldc); \
+void pack_##NAME(long *src, T *dst, long count); \
+void unpack_##NAME(T *src, long *dst, long count); \
+void process_##NAME(T *a, T **b, T *c, T **spare, int N, int rank, int numprocs); \
+void redistribute_##NAME(T *a, T *b, T *out, T *in, int N, int rank, int numprocs); \
+Matrix *compute_##NAME(Matrix *a, Matrix *b, Workspace *ws, Checkpoint *cp, int first, int N, int engine, int rank, int numprocs); \
+void relax_##NAME(T *c, T *a, T *b, int h, int w, int depth, int ld); \
+void floyd_shared_##NAME(Matrix *m);
+DECLARE_COMPACT(int32_t, int32)
+DECLARE_COMPACT(uint16_t, uint16)
+int select_element(Matrix *a, int n, int element, MPI_Comm comm);                                       //choisit le type le plus petit qui contient le plus long chemin possible sur les machines de comm, le type imposé si il y tient
 
 //Utils
 void set(Matrix *matrix, int row, int column, long value);                                              //assigne la valeur dans la bonne case de la matrice
 long get(Matrix *matrix, int row, int column);                                                          //retourne la valeur à la case correspondance
 int size(Matrix *matrix);                                                                               //retourne le nombre d'element d'une matrice
+int gcd(int a, int b);                                                                                  //retourne le plus grand diviseur commun
 void display_array(long *array, int size);                                                              //affiche le tableau
-void display_matrix(Matrix *m);                                                                         //affiche la matrice en supprimant les ajouts eventuelle. a utiliser seulement pour la matrice final
+void display_matrix(Matrix *m);                                                                         //affiche la matrice
+int format_value(long value, char *out);                                                                //écrit la valeur en texte dans out et retourne sa longueur
+int write_rows(char *path, Matrix *rows, int first_row, int n, bool binary, MPI_Comm comm);             //chaque machine écrit ses lignes dans le fichier avec MPI-IO
+int parse_options(int argc, char *argv[], Options *options);                                            //lit les arguments de la ligne de commande
+int *parse_list(char *text, int *count);                                                                //lit une liste d'entiers positifs séparés par des virgules, NULL si elle est invalide
+int path(long *pred, int N, int i, int j, int *nodes);                                                  //reconstruit le chemin de i à j depuis la ligne i des prédécesseurs, retourne son nombre de sommets ou 0
+void display_path(long *pred, int N, int i, int j);                                                     //affiche le chemin de i à j, pred est la ligne i ou NULL si i n'existe pas
 
 //Creation matrice
 Matrix *generate_matrix(long *data, int h, int w, bool row_opti);                                       //genere une matrice
 Matrix *create_matrix(int seed, int h, int w, bool row_opti);                                           //creer une matrice 
-Matrix *load_matrix(char *path, int numprocs);                                                      //  //charge une matrice depuis un fichier en la transformant avec i et l'ajustant pour etre divisible par le nombre de procos
+Matrix *load_matrix(char *path);                                                                    //  //charge une matrice depuis un fichier en remplacant les absences d'arc par l'infini
 Matrix *copy_matrix(Matrix *m, bool row_opti);                                                      //  //copy une matrix avec l'optimisation demandée
+int adjust(int N, int numprocs);                                                                        //retourne N ajusté pour etre divisible par le nombre de procos, pour les tuiles égales de la grille
+long *read_updates(char *path, int *count, int transmitter, MPI_Comm comm);                             //lit les arcs u v w chez l'emmeteur et les transmet à toutes les machines
+
+//Format binaire
+int read_header(char *path, Header *header);                                                            //lit l'entete d'un fichier binaire, retourne 1 si ce n'en est pas un, arrete tout si ses valeurs ne sont pas sur 8 octets
+int write_binary(Matrix *m, char *path);                                                                //écrit la matrice au format binaire
+Matrix *load_block(char *path, Header *header, int row, int column, int height, int width, bool row_opti, MPI_Comm comm); // //lit un bloc de la matrice ajustée avec MPI-IO
+
+//Mémoire
+Arena create_arena(long size);                                                                          //alloue une zone mémoire de size valeurs
+long *arena_alloc(Arena *arena, long size);                                                             //réserve size valeurs dans la zone
+void free_arena(Arena *arena);                                                                          //libere la zone et tous ses tampons
+Workspace create_workspace(Matrix *a, Matrix *b, int numprocs);                                        //alloue les tampons utilisés par process et redistribute, a et b y sont déplacées
+void first_touch(long *dst, long *src, int rows, long width);                                       //  //copie les lignes de src dans dst, chaque thread touche en premier les lignes qu'il calculera
+void free_workspace(Workspace *ws);                                                                     //libere les tampons de l'espace de travail, a et b comprises
+Matrix *init_predecessors(Matrix *m, int row, int column);                                              //prédécesseurs des arcs de m, m commence à la ligne row et à la colonne column
+Paths create_paths(Matrix *a, Matrix *b, int rank, int numprocs);                                       //prédécesseurs initiaux des blocs a et b et leurs tampons
+void free_paths(Paths *paths);                                                                          //libere les prédécesseurs et leurs tampons
 
 //Tests
 int test(int rank, int numprocs);                                                                       //tests
@@ -67,52 +496,293 @@ int test(int rank, int numprocs);
 //-----------------------------------------------------------------
 int main(int argc, char *argv[])
 {
-    int rank, numprocs, N;
-    Matrix *A, *B, *a, *b;
+    int rank, numprocs, N = 0, M, count, provided;
+    Matrix *A = NULL, *P = NULL, *a, *b, *stripe;
+    Options options;
+    Grid grid;
+    Workspace ws;
+    Paths paths, *tracked = NULL;
+    Graph *g = NULL;
+    Header header;
+    bool binary;
+    uint64_t *rows;
 
-    //initialisation de MPI
-    MPI_Init(&argc, &argv);
+    //initialisation de MPI, seul le thread maitre de chaque rang appelle MPI pendant les régions OpenMP
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
     MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
 
     //vérifie si il y a le bon nombre d'argument
-    if(argc != 2) 
+    if(parse_options(argc, argv, &options)) 
     {
         if(rank == TRANSMITTER) printf("Program is call with wrong numbers of argument... exit\n");
+        if(rank == TRANSMITTER) printf("usage : bruel [-e auto|sparse|ring|square|floyd|summa|shared|none] [-d ring|collective] [-t auto|long|int32|uint16] [-k scalar|avx2|avx512] [-c <binary_file>] [-o <output_file> [-b]] [-q <i> <j>]... [-u <updates_file>] [-p] [-s] [-H] [-T <trace_prefix>] [-C <checkpoint_file> [-K <iterations>] [-R]] [-a] <data_file>\n");
+        if(rank == TRANSMITTER) printf("       bruel -M <manifest> [-t auto|long|int32|uint16] [-k ...] [-b] [-H] [-T <trace_prefix>]\n");
+        if(rank == TRANSMITTER) printf("       bruel -B dense|er|grid [-n <sizes>] [-j <threads>] [-S <seed>] [-D <density>] [-e ...] [-d ...] [-t ...] [-k ...] [-o <output_file> [-b]] [-H] [-T <trace_prefix>]\n");
+        MPI_Finalize();
+        return 0;
+    }
+
+    //sans MPI_THREAD_FUNNELED le thread maitre ne peut pas appeler MPI pendant les régions OpenMP :
+    //tout le calcul se fait alors sur un seul thread, -H et -j ne peuvent plus en ajouter
+    if(provided < MPI_THREAD_FUNNELED)
+    {
+        if(rank == TRANSMITTER) fprintf(stderr, "MPI does not provide MPI_THREAD_FUNNELED, running with one OpenMP thread\n");
+        omp_set_num_threads(1);
+        options.hybrid = false;
+        options.nb_threads = 0;
+    }
+
+    //choisit le noyau min-plus
+    minplus = select_kernel(options.kernel);
+
+    //en mode hybride les rangs d'un meme noeud se partagent ses coeurs
+    if(options.hybrid) hybrid_threads();
+
+    //chaque machine note ses phases et ses échanges à partir d'ici, les tests ne sont pas tracés
+    if(options.trace != NULL && (options.path == NULL || strcmp(options.path, "test") != 0)) open_trace();
+
+    //mesure le moteur sur des graphes générés, sans fichier de données
+    if(options.generator != GENERATOR_NONE)
+    {
+        benchmark(&options, rank, numprocs);
+        close_trace(options.trace, rank, numprocs);
+        MPI_Finalize();
+        return 0;
+    }
+
+    //résout indépendamment chaque graphe de la liste, sans fichier de données
+    if(options.manifest != NULL)
+    {
+        batch(&options, rank, numprocs);
+        close_trace(options.trace, rank, numprocs);
         MPI_Finalize();
         return 0;
     }
 
     //lance les tests
-    if(strcmp(argv[1],"test")==0)
+    if(strcmp(options.path,"test")==0)
     {
         test(rank, numprocs);
         MPI_Finalize();
         return 0;
     }
 
-    //lit la matrice si il s'agit de l'emmetteur et en déduit A, B et N
-    if(rank == TRANSMITTER)
+    //convertit le fichier texte au format binaire
+    if(options.convert != NULL)
+    {
+        //une conversion ratée, fichier absent ou écriture incomplète, termine le programme en erreur
+        if(rank == TRANSMITTER && write_binary(load_matrix(options.path), options.convert))
+        {
+            printf("Conversion of %s failed... exit\n", options.path);
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        MPI_Finalize();
+        return 0;
+    }
+
+    //les prédécesseurs, les mises à jour et les checkpoints ne s'appliquent qu'aux bandes de lignes des moteurs en anneau
+    //le moteur d'une seule machine devient Floyd-Warshall sur la grille si plusieurs machines sont lancées
+    if((options.paths || options.updates != NULL || options.service || options.checkpoint != NULL) && (options.engine == ENGINE_FLOYD || options.engine == ENGINE_SUMMA || options.engine == ENGINE_SHARED)) options.engine = ENGINE_SQUARE;
+    if(options.engine == ENGINE_SHARED && numprocs > 1) options.engine = ENGINE_FLOYD;
+
+    //les tuiles de la grille restent en long, un type compact demandé n'y est pas appliqué
+    if((options.engine == ENGINE_FLOYD || options.engine == ENGINE_SUMMA) && (options.element == ELEMENT_INT32 || options.element == ELEMENT_UINT16))
+    {
+        if(rank == TRANSMITTER) fprintf(stderr, "-t is not supported by the floyd and summa engines, computing in long\n");
+        options.element = ELEMENT_LONG;
+    }
+
+    //l'accessibilité a son propre calcul, la matrice est lue dense comme pour l'anneau puis compressée en bits
+    if(options.reachability) options.engine = ENGINE_RING;
+
+    //un fichier binaire est lu en parallele, chaque machine lit directement ses blocs
+    binary = read_header(options.path, &header) == 0;
+
+    //le moteur creux et le choix automatique lisent d'abord le graphe en CSR pour connaitre sa densité
+    //les arcs ne sont transmis à toutes les machines que si le moteur creux est retenu
+    if(options.engine == ENGINE_AUTO || options.engine == ENGINE_SPARSE)
     {
-        A = load_matrix(argv[1], numprocs);
+        g = read_graph(options.path, &header, binary, rank, numprocs);
+        options.engine = select_engine(g, &options);
+        if(options.engine == ENGINE_SPARSE && !binary) broadcast_graph(g, TRANSMITTER, rank);
+    }
+
+    //lit la matrice si il s'agit de l'emmetteur et en déduit A et N
+    //les colonnes de B sont découpées directement dans A, sans copie optimisée en colonne
+    if(rank == TRANSMITTER && !binary && options.engine != ENGINE_SPARSE)
+    {
+        A = g != NULL ? graph_matrix(g) : load_matrix(options.path);
         N = A->height;
-        B=copy_matrix(A, false);
     }
 
-    //transmet N à toutes les machines du réseau
-    N = broadcast(N, TRANSMITTER, rank, numprocs);
-    //transmet un bloc de B a chaque machine du réseau
-    b = scatter(B, N, false, TRANSMITTER, rank, numprocs);
-    a = scatter(A, N, true, TRANSMITTER, rank, numprocs);
+    //le graphe lu pour choisir le moteur n'est plus utile aux moteurs denses
+    if(g != NULL && options.engine != ENGINE_SPARSE)
+    {
+        free_graph(g);
+        g = NULL;
+    }
+
+    //transmet N à toutes les machines du réseau, la matrice n'est pas ajustée au nombre de procos
+    //chaque machine en déduit les lignes qu'elle possède avec FIRST et PART
+    if(options.engine == ENGINE_SPARSE) N = g->n;
+    else if(binary) N = header.size;
+    else if(options.distribution == DISTRIBUTION_COLLECTIVE) N = broadcast_collective(N, TRANSMITTER);
+    else N = broadcast(N, TRANSMITTER, rank, numprocs);
+    trace_phase(PHASE_LOAD);
+
+    if(options.reachability)
+    {
+        //les lignes sont compressées avant la répartition, la fermeture transitive ne manipule que des bits
+        if(binary)
+        {
+            a = load_block(options.path, &header, FIRST(rank, numprocs, N), 0, PART(rank, numprocs, N), N, true, MPI_COMM_WORLD);
+            rows = pack_bits(a);
+            free(a->array);
+            free(a);
+        }
+        else rows = scatter_bits(A, N, TRANSMITTER, rank, numprocs);
+        if(!binary && rank == TRANSMITTER) free(A->array);
+        if(!binary && rank == TRANSMITTER) free(A);
+        trace_phase(PHASE_SCATTER);
+        rows = closure(rows, N, rank, numprocs);
+        trace_phase(PHASE_COMPUTE);
+
+        //le résultat s'écrit en 0 et 1 comme des distances, il n'est décompressé qu'au dernier moment
+        if(options.output != NULL)
+        {
+            a = unpack_bits(rows, PART(rank, numprocs, N), N);
+            write_rows(options.output, a, FIRST(rank, numprocs, N), N, options.binary_output, MPI_COMM_WORLD);
+            free(a->array);
+            free(a);
+        }
+        else A = gather_bits(rows, N, TRANSMITTER, rank, numprocs);
+        trace_phase(options.output != NULL ? PHASE_OUTPUT : PHASE_GATHER);
+        free(rows);
+    }
+    else if(options.engine == ENGINE_SHARED)
+    {
+        //une seule machine : Floyd-Warshall par blocs directement sur la matrice lue, sans répartition ni assemblage
+        if(binary) A = load_block(options.path, &header, 0, 0, N, N, true, MPI_COMM_SELF);
+        trace_phase(PHASE_SCATTER);
+        floyd_shared(A, options.element);
+        trace_phase(PHASE_COMPUTE);
+        if(options.output != NULL) write_rows(options.output, A, 0, N, options.binary_output, MPI_COMM_SELF);
+        if(options.output != NULL) trace_phase(PHASE_OUTPUT);
+    }
+    else if(options.engine == ENGINE_SPARSE)
+    {
+        //chaque machine calcule les distances depuis ses lignes, le résultat est réparti comme celui des autres moteurs
+        a = sparse(g, rank, numprocs);
+        free_graph(g);
+        trace_phase(PHASE_COMPUTE);
+        if(options.output != NULL) write_rows(options.output, a, FIRST(rank, numprocs, N), N, options.binary_output, MPI_COMM_WORLD);
+        else A = gather_collective(TRANSMITTER,rank,numprocs,a);
+        trace_phase(options.output != NULL ? PHASE_OUTPUT : PHASE_GATHER);
+        free(a->array);
+        free(a);
+    }
+    else if(options.engine == ENGINE_FLOYD || options.engine == ENGINE_SUMMA)
+    {
+        //répartit les tuiles sur la grille, applique Floyd-Warshall par blocs ou les carrés SUMMA et assemble le résultat
+        //les tuiles doivent etre égales : seule la grille complète la matrice à M sommets par des lignes et colonnes infinies
+        grid = create_grid(MPI_COMM_WORLD);
+        M = adjust(N, numprocs);
+        if(binary) a = load_block(options.path, &header, grid.row*(M/grid.rows), grid.column*(M/grid.columns), M/grid.rows, M/grid.columns, true, MPI_COMM_WORLD);
+        else a = scatter_grid(A, M, &grid, TRANSMITTER);
+        trace_phase(PHASE_SCATTER);
+        if(options.engine == ENGINE_FLOYD) floyd(a, M, &grid);
+        else summa(a, M, &grid);
+        trace_phase(PHASE_COMPUTE);
+
+        //chaque ligne de la grille assemble ses lignes sur sa premiere colonne qui les écrit
+        if(options.output != NULL)
+        {
+            stripe = gather_row_tiles(a, M, &grid);
+            write_rows(options.output, stripe, grid.row*(M/grid.rows), N, options.binary_output, MPI_COMM_WORLD);
+        }
+        else A = gather_grid(a, N, &grid, TRANSMITTER);
+        trace_phase(options.output != NULL ? PHASE_OUTPUT : PHASE_GATHER);
+    }
+    else
+    {
+        //transmet un bloc de B a chaque machine du réseau
+        if(binary)
+        {
+            b = load_block(options.path, &header, 0, FIRST(rank, numprocs, N), N, PART(rank, numprocs, N), false, MPI_COMM_WORLD);
+            a = load_block(options.path, &header, FIRST(rank, numprocs, N), 0, PART(rank, numprocs, N), N, true, MPI_COMM_WORLD);
+        }
+        else if(options.distribution == DISTRIBUTION_COLLECTIVE)
+        {
+            b = scatter_collective(A, N, false, TRANSMITTER, rank, numprocs);
+            a = scatter_collective(A, N, true, TRANSMITTER, rank, numprocs);
+        }
+        else
+        {
+            b = scatter(A, N, false, TRANSMITTER, rank, numprocs);
+            a = scatter(A, N, true, TRANSMITTER, rank, numprocs);
+        }
+        if(!binary && rank == TRANSMITTER) free(A->array);
+        if(!binary && rank == TRANSMITTER) free(A);
+
+        //les prédécesseurs sont initialisés avec les arcs et tournent avec les distances
+        if(options.paths)
+        {
+            paths = create_paths(a, b, rank, numprocs);
+            tracked = &paths;
+        }
+
+        //multiplie a avec b, tous les tampons des itérations sont alloués avant la boucle
+        //si le plus long chemin possible le permet les blocs sont convertis dans un type plus petit
+        ws = create_workspace(a, b, numprocs);
+        trace_phase(PHASE_SCATTER);
+        a = solve(a, b, &ws, tracked, &options, N, rank, numprocs);
+
+        //les arcs modifiés sont appliqués sur les distances sans tout recalculer
+        if(options.updates != NULL)
+        {
+            long *updates = read_updates(options.updates, &count, TRANSMITTER, MPI_COMM_WORLD);
+            count = apply_updates(a, tracked, updates, count, MPI_COMM_WORLD);
+            if(rank == TRANSMITTER && count > 0) printf("%d updates ignored\n", count);
+            free(updates);
+        }
+        trace_phase(PHASE_COMPUTE);
+
+        //les distances restent réparties sur les machines et répondent aux commandes
+        if(options.service)
+        {
+            serve(a, b, &ws, tracked, &options, N, rank, numprocs);
+            close_trace(options.trace, rank, numprocs);
+            MPI_Finalize();
+            return 0;
+        }
 
-    //multiplie a avec b
-    for(int i = 0; i < N; i++) a = process(a,b,rank,numprocs);
+        //chaque machine écrit ses lignes, ou on assemble a pour reconstituer la matrice finale
+        if(options.output != NULL) write_rows(options.output, a, FIRST(rank, numprocs, N), N, options.binary_output, MPI_COMM_WORLD);
+        else if(options.distribution == DISTRIBUTION_COLLECTIVE) A = gather_collective(TRANSMITTER,rank,numprocs,a);
+        else A = gather(TRANSMITTER,rank,numprocs,a);
+
+        //les prédécesseurs sont assemblés de la meme facon, meme si les distances sont écrites dans un fichier
+        if(tracked != NULL && options.distribution == DISTRIBUTION_COLLECTIVE) P = gather_collective(TRANSMITTER,rank,numprocs,paths.a);
+        else if(tracked != NULL) P = gather(TRANSMITTER,rank,numprocs,paths.a);
+        trace_phase(options.output != NULL ? PHASE_OUTPUT : PHASE_GATHER);
+        if(tracked != NULL) free_paths(&paths);
+        free_workspace(&ws);
+        free(a);
+        free(b);
+    }
 
-    //assemble a pour reconstituer la matrice finale
-    A = gather(TRANSMITTER,rank,numprocs,a);
+    //affiche le résultat si il n'a pas été écrit dans un fichier
+    if(rank == TRANSMITTER && options.output == NULL) display_matrix(A);
 
-    //affiche le résultat
-    if(rank == TRANSMITTER) display_matrix(A);
+    //affiche le chemin de chaque paire demandée
+    for(int q = 0; rank == TRANSMITTER && q < options.nb_queries; q++)
+    {
+        int i = options.queries[2*q];
+        display_path(i >= 0 && i < N ? P->array + (long) i*N : NULL, N, i, options.queries[2*q+1]);
+    }
+    if(options.output == NULL) trace_phase(PHASE_OUTPUT);
+    close_trace(options.trace, rank, numprocs);
     
     MPI_Finalize();
     return 0;
@@ -144,43 +814,57 @@ int broadcast(int data, int transmitter, int rank, int numprocs)
 
 Matrix *scatter(Matrix *data, int size, bool row_opti, int transmitter, int rank, int numprocs)
 {
-    int block_size;
+    int block_size, owner;
     MPI_Status status;
     long *block;
+    double start;
+    Matrix *part;
 
     //Dans le cas ou on est l'emmetteur
-    //On découpe la matice en numprocs part
-    //On envoie chaque part une par une à la machine suivante
+    //On découpe la matice en numprocs part, de PART lignes (ou colonnes) chacune
+    //les colonnes sont copiées par tuiles dans un tampon optimisé en colonne, sans copie transposée de toute la matrice
+    //On envoie chaque part une par une à la machine suivante et on garde la notre, extraite en dernier
     if(transmitter == rank)
     {        
-        block_size = (size*size / numprocs);
-
-        for(int p = 1; p < numprocs; p++)
+        block = (long *) malloc(sizeof(long) * MAX_PART(numprocs, size) * size);
+        part = generate_matrix(block, size, size, row_opti);
+        for(int p = 1; p <= numprocs; p++)
         {
             //calcule du bloc à envoyé (le dernier bloc est envoyé en premier)
-            block = data->array + CURRENT(rank-p, numprocs) * block_size;                                             
-            MPI_Send(block, block_size, MPI_LONG, NEXT(rank, numprocs), SCATTER, MPI_COMM_WORLD);
+            owner = CURRENT(rank-p, numprocs);
+            if(row_opti) part->height = PART(owner, numprocs, size);
+            else part->width = PART(owner, numprocs, size);
+            extract(data, part, row_opti ? FIRST(owner, numprocs, size) : 0, row_opti ? 0 : FIRST(owner, numprocs, size));
+            if(owner == rank) break;
+            start = trace_start();
+            MPI_Send(block, part->height * part->width, MPI_LONG, NEXT(rank, numprocs), SCATTER, MPI_COMM_WORLD);
+            trace_stop(EVENT_RELAY, start, 0);
         }
-        block = (long *) malloc(sizeof(long) * block_size);
-        memmove(block,data->array + CURRENT(rank, numprocs)* block_size, block_size * sizeof(long));
-        free(data);
+        block_size = part->height * part->width;
+        free(part);
     }
 
     //Dans le cas ou on est une autre machine
-    //On transmet les part qui ne nous sont pas dédié à la machine suivante
+    //On transmet les part qui ne nous sont pas dédié à la machine suivante, le tampon peut contenir la plus grande
     //On conserve la derniere part
     else
     {
-        MPI_Probe(PREVIOUS(rank, numprocs), SCATTER, MPI_COMM_WORLD, &status);
-        MPI_Get_count(&status, MPI_LONG, &block_size);
-        block = (long *) malloc(sizeof(long) * block_size);
+        block = (long *) malloc(sizeof(long) * MAX_PART(numprocs, size) * size);
 
         for(int i = rank; i != PREVIOUS(transmitter,numprocs); i=NEXT(i,numprocs))
         {
-            MPI_Recv(block, block_size, MPI_LONG, PREVIOUS(rank, numprocs), SCATTER, MPI_COMM_WORLD, &status);
+            start = trace_start();
+            MPI_Recv(block, MAX_PART(numprocs, size) * size, MPI_LONG, PREVIOUS(rank, numprocs), SCATTER, MPI_COMM_WORLD, &status);
+            MPI_Get_count(&status, MPI_LONG, &block_size);
             MPI_Send(block, block_size, MPI_LONG, NEXT(rank, numprocs), SCATTER, MPI_COMM_WORLD);
+            counters.bytes += block_size * sizeof(long);
+            trace_stop(EVENT_RELAY, start, block_size * sizeof(long));
         }
+        block_size = PART(rank, numprocs, size) * size;
+        start = trace_start();
         MPI_Recv(block, block_size, MPI_LONG, PREVIOUS(rank, numprocs), SCATTER, MPI_COMM_WORLD, &status);
+        counters.bytes += block_size * sizeof(long);
+        trace_stop(EVENT_RELAY, start, block_size * sizeof(long));
     }
 
 
@@ -192,203 +876,3114 @@ Matrix *scatter(Matrix *data, int size, bool row_opti, int transmitter, int rank
 Matrix *gather(int transmitter, int rank, int numprocs, Matrix *matrix)
 {
     MPI_Status status;
-    Matrix *result;
-    int block_size = size(matrix);
-    long *block = matrix->array;
+    Matrix *result = NULL;
+    int N = matrix->width, block_size;
+    long *block;
+    double start;
 
     //Dans le cas ou on est l'emmetteur
     //On genere une matrice vide
-    //rempli le debut de la matrice avec notre block
-    //rempli le reste de la matrice avec les blocs qui arrivent
+    //rempli la matrice avec notre block à la position de nos lignes
+    //rempli le reste de la matrice avec les blocs qui arrivent, chacun directement à sa position
     if(rank==transmitter)
     {
-        int size = block_size*numprocs;
-        result = generate_matrix(malloc(size*sizeof(long)),matrix->width, matrix->width, true);
-        memmove(result->array  + rank * block_size,block, block_size * sizeof(long));
+        result = generate_matrix(malloc((long) N*N*sizeof(long)), N, N, true);
+        memmove(result->array + FIRST(rank, numprocs, N) * (long) N, matrix->array, size(matrix) * sizeof(long));
         for(int i = PREVIOUS(rank,numprocs); i != CURRENT(rank,numprocs); i=PREVIOUS(i,numprocs))
         {
-            MPI_Recv(block, block_size, MPI_LONG, PREVIOUS(rank, numprocs), GATHER, MPI_COMM_WORLD, &status);
-            memmove(result->array + i * block_size, block, block_size  * sizeof(long));
+            block = result->array + FIRST(i, numprocs, N) * (long) N;
+            start = trace_start();
+            MPI_Recv(block, PART(i, numprocs, N) * N, MPI_LONG, PREVIOUS(rank, numprocs), GATHER, MPI_COMM_WORLD, &status);
+            counters.bytes += PART(i, numprocs, N) * N * sizeof(long);
+            trace_stop(EVENT_RELAY, start, PART(i, numprocs, N) * N * sizeof(long));
         }  
     }
     //Dans le cas ou on est une autre machine
     //On envoie notre block au suivant
-    //On receptionne les block des machines precedentes
+    //On receptionne les block des machines precedentes dans un tampon qui peut contenir le plus grand
     //On envoie leurs blocks 
     else
     {
-        MPI_Send(block, block_size, MPI_LONG, NEXT(rank, numprocs), GATHER, MPI_COMM_WORLD);
+        block = (long *) malloc(MAX_PART(numprocs, N) * N * sizeof(long));
+        start = trace_start();
+        MPI_Send(matrix->array, size(matrix), MPI_LONG, NEXT(rank, numprocs), GATHER, MPI_COMM_WORLD);
+        trace_stop(EVENT_RELAY, start, 0);
         for(int i = rank; i != NEXT(transmitter,numprocs); i=PREVIOUS(i,numprocs))
         {
-            MPI_Recv(block, block_size, MPI_LONG, PREVIOUS(rank, numprocs), GATHER, MPI_COMM_WORLD, &status);
+            start = trace_start();
+            MPI_Recv(block, MAX_PART(numprocs, N) * N, MPI_LONG, PREVIOUS(rank, numprocs), GATHER, MPI_COMM_WORLD, &status);
+            MPI_Get_count(&status, MPI_LONG, &block_size);
             MPI_Send(block, block_size, MPI_LONG, NEXT(rank, numprocs), GATHER, MPI_COMM_WORLD);
+            counters.bytes += block_size * sizeof(long);
+            trace_stop(EVENT_RELAY, start, block_size * sizeof(long));
         }
+        free(block);
+    }
+    return result;
+}
+
+
+int broadcast_collective(int data, int transmitter)
+{
+    MPI_Bcast(&data, 1, MPI_INT, transmitter, MPI_COMM_WORLD);
+    return data;
+}
+
+
+Matrix *scatter_collective(Matrix *data, int size, bool row_opti, int transmitter, int rank, int numprocs)
+{
+    int part = PART(rank, numprocs, size);
+    int *counts = (int *) malloc(numprocs*sizeof(int)), *displs = (int *) malloc(numprocs*sizeof(int));
+    long *block = (long *) malloc(sizeof(long) * size * part);
+    MPI_Datatype tmp, column;
+    double start = trace_start(), received = rank != transmitter ? (double) size * part * sizeof(long) : 0;
+
+    counters.bytes += received;
+
+    //Les bandes de lignes sont contigues dans data, MPI_Scatterv les découpe avec la taille et la position de chaque part
+    if(row_opti)
+    {
+        partition(size, numprocs, size, counts, displs);
+        MPI_Scatterv(rank == transmitter ? data->array : NULL, counts, displs, MPI_LONG, block, size*part, MPI_LONG, transmitter, MPI_COMM_WORLD);
+        trace_stop(EVENT_DISTRIBUTE, start, received);
+        free(counts);
+        free(displs);
+        return generate_matrix(block, part, size, row_opti);
     }
+
+    //Les colonnes sont décrites par un type dérivé :
+    //  à l'envoi, size valeurs espacées d'une ligne, la colonne suivante commence une valeur plus loin
+    //  chaque machine recoit les colonnes de sa part les unes à la suite des autres, le bloc est donc optimisé en colonne
+    MPI_Type_vector(size, 1, size, MPI_LONG, &tmp);
+    MPI_Type_create_resized(tmp, 0, sizeof(long), &column);
+    MPI_Type_commit(&column);
+    MPI_Type_free(&tmp);
+
+    partition(size, numprocs, 1, counts, displs);
+    MPI_Scatterv(rank == transmitter ? data->array : NULL, counts, displs, column, block, size*part, MPI_LONG, transmitter, MPI_COMM_WORLD);
+    trace_stop(EVENT_DISTRIBUTE, start, received);
+
+    MPI_Type_free(&column);
+    free(counts);
+    free(displs);
+    return generate_matrix(block, size, part, row_opti);
+}
+
+
+Matrix *gather_collective(int transmitter, int rank, int numprocs, Matrix *matrix)
+{
+    Matrix *result = NULL;
+    int N = matrix->width;
+    int *counts = (int *) malloc(numprocs*sizeof(int)), *displs = (int *) malloc(numprocs*sizeof(int));
+
+    //les bandes de lignes, de tailles différentes, sont rangées les unes à la suite des autres chez l'emmeteur
+    if(rank == transmitter) result = generate_matrix((long *) malloc((long) N*N*sizeof(long)), N, N, true);
+    double start = trace_start(), received = rank == transmitter ? ((double) N*N - size(matrix)) * sizeof(long) : 0;
+
+    counters.bytes += received;
+    partition(N, numprocs, N, counts, displs);
+    MPI_Gatherv(matrix->array, size(matrix), MPI_LONG, rank == transmitter ? result->array : NULL, counts, displs, MPI_LONG, transmitter, MPI_COMM_WORLD);
+    trace_stop(EVENT_DISTRIBUTE, start, received);
+    free(counts);
+    free(displs);
     return result;
 }
 
 
-Matrix *process(Matrix *a, Matrix *b, int rank, int numprocs)
+void partition(int n, int numprocs, int unit, int *counts, int *displs)
+{
+    //la machine p possède les lignes FIRST(p) à FIRST(p+1)-1 de unit valeurs chacune
+    for(int p = 0; p < numprocs; p++)
+    {
+        counts[p] = PART(p, numprocs, n) * unit;
+        displs[p] = FIRST(p, numprocs, n) * unit;
+    }
+}
+
+
+Matrix *process(Matrix *a, Matrix *b, Workspace *ws, Paths *paths, int rank, int numprocs)
 {
-    Matrix *p;
     long *tmp;
-    MPI_Status status; 
-    Matrix *c = generate_matrix((long *) malloc(size(a)*sizeof(long)), a->height, a->width, a->row_opti);
+    MPI_Request requests[4];
+    int done, count = paths == NULL ? 2 : 4, *places = (int *) malloc(omp_get_max_threads()*sizeof(int));
+    Matrix *c = ws->c, *pc;
+    double start, received;
 
     //Pour chaque procos on traite la matrice
-    //  On ajoute le résultat dans la matrice final
-    //  Si on est pair, on envoie et on receprionne la matrice b
-    //  Si on est impaire, on receprionne et on envoie la matrice b
+    //  On lance l'envoi de b à la machine suivante et la réception du bloc précédent dans le second tampon
+    //  les blocs n'ont pas tous la meme largeur, celle du bloc recu est celle de la part de la machine source
+    //  les prédécesseurs de b circulent de la meme facon
+    //  On calcule le produit pendant que le bloc circule
+    //  On attend la fin de l'échange et on permute les deux tampons
     for(int i = 0; i < numprocs; i++)
     {
-        //On fait le produit des 2 matrices
-        p = matrix_process(a,b);
+        int N = a->width, source = CURRENT(rank-i-1,numprocs);
+        int column = FIRST(CURRENT(rank-i,numprocs), numprocs, N), incoming = PART(source, numprocs, N);
+        start = trace_start();
+        MPI_Irecv(ws->spare->array, incoming*N, MPI_LONG, PREVIOUS(rank, numprocs), PROCESS, MPI_COMM_WORLD, &requests[0]);
+        MPI_Isend(b->array, size(b), MPI_LONG, NEXT(rank, numprocs), PROCESS, MPI_COMM_WORLD, &requests[1]);
+        if(paths != NULL)
+        {
+            MPI_Irecv(paths->ws.spare->array, incoming*N, MPI_LONG, PREVIOUS(rank, numprocs), PATHS, MPI_COMM_WORLD, &requests[2]);
+            MPI_Isend(paths->b->array, size(b), MPI_LONG, NEXT(rank, numprocs), PATHS, MPI_COMM_WORLD, &requests[3]);
+        }
 
-        //On remplace dans la matrice résultante la multiplication trouvée
+        //On fait le produit des 2 matrices par paquets de lignes pour faire avancer l'échange entre deux paquets
+        //et on l'écrit directement dans la matrice résultante
         //à l'emplacement déterminé celon le rank, l'iteration et la taille d'un bloc
-        replace(c, p, 0, CURRENT(rank-i,numprocs)*a->width/numprocs);
-        free(p);
-
-        if(rank % 2 == 0)
+        //chaque place calcule toujours la meme part des lignes, celle que son thread a touchée en premier dans create_workspace,
+        //elles restent ainsi dans la mémoire de son socket ; seul le thread maitre fait avancer l'échange
+        #pragma omp parallel proc_bind(close)
         {
-            MPI_Send(b->array, size(b), MPI_LONG, NEXT(rank, numprocs), PROCESS, MPI_COMM_WORLD);
-            MPI_Recv(b->array, size(b), MPI_LONG, PREVIOUS(rank, numprocs), PROCESS, MPI_COMM_WORLD, &status);
+            int t = omp_get_thread_num(), threads = omp_get_num_threads(), s = thread_slot(places), last = FIRST(s + 1, threads, a->height);
+            for(int r = FIRST(s, threads, a->height); r < last; r += PROGRESS_ROWS)
+            {
+                int rows = r + PROGRESS_ROWS < last ? PROGRESS_ROWS : last - r;
+                long offset = (long) r*c->width + column;
+                if(paths == NULL) minplus_store(a->array + (long) r*a->width, b->array, c->array + offset, rows, a->width, b->width, c->width);
+                else minplus_path(a->array + (long) r*a->width, b->array, paths->a->array + offset, paths->b->array, c->array + offset, paths->ws.c->array + offset, rows, a->width, b->width, c->width, column);
+                if(t == 0) MPI_Testall(count, requests, &done, MPI_STATUSES_IGNORE);
+            }
         }
-        else
+
+        //le temps d'attente est celui de l'échange qui n'a pas pu etre recouvert par le calcul
+        trace_stop(EVENT_RING_COMPUTE, start, 0);
+        start = trace_start();
+        MPI_Waitall(count, requests, MPI_STATUSES_IGNORE);
+        received = numprocs > 1 ? (double) incoming * N * sizeof(long) * count / 2 : 0;
+        counters.operations += (double) a->height * a->width * b->width;
+        counters.bytes += received;
+        trace_stop(EVENT_RING_WAIT, start, received);
+        tmp = b->array;
+        b->array = ws->spare->array;
+        ws->spare->array = tmp;
+        b->width = incoming;
+        if(paths != NULL)
         {
-            tmp = (long *) malloc(size(b)*sizeof(long));
-            MPI_Recv(tmp, size(b), MPI_LONG, PREVIOUS(rank, numprocs), PROCESS, MPI_COMM_WORLD, &status);
-            MPI_Send(b->array, size(b), MPI_LONG, NEXT(rank, numprocs), PROCESS, MPI_COMM_WORLD);
-            b->array=tmp;
+            tmp = paths->b->array;
+            paths->b->array = paths->ws.spare->array;
+            paths->ws.spare->array = tmp;
+            paths->b->width = incoming;
         }
     }
+    free(places);
+
+    //l'ancienne matrice devient le tampon résultat de la prochaine itération
+    ws->c = a;
+    if(paths != NULL)
+    {
+        pc = paths->ws.c;
+        paths->ws.c = paths->a;
+        paths->a = pc;
+    }
     return c;
 }
 
 
-
-
-//-----------------------------------------------------------------
-//--------------------MANIPULATION DE MATRICE----------------------
-//-----------------------------------------------------------------
-Matrix *matrix_process(Matrix *m1, Matrix *m2)
+Matrix *square(Matrix *a, Matrix *b, Workspace *ws, Paths *paths, Checkpoint *cp, int first, int N, int rank, int numprocs)
 {
-    //genere une matrice avec pour hauteur m1 et pour largeur m2
-    Matrix *res = generate_matrix((long *) malloc(m1->height*m2->width*sizeof(long)), m1->height, m2->width, true);
-    int n=m1->height, p=m1->width, m=m2->width;
+    Matrix *c;
+    int changed = 1, steps = 1;
 
-    //remplace dans la multiplication classique de matrice l'opération de multiplication par une addition et l'opération de somme par le minimum 
-    #pragma omp parallel for
-    for(int r = 0; r < n; r++)
+    //2^steps doit couvrir les chemins de N-1 arcs au maximum
+    while((1 << steps) < N - 1) steps++;
+
+    //A chaque itération a contient les lignes de A^(2^k) et b ses colonnes
+    //  On calcule le carré de la matrice avec l'anneau habituel
+    //  On vérifie sur toutes les machines si une valeur a changé, sinon on s'arrete
+    //  On reconstruit les colonnes b à partir des nouvelles lignes pour l'itération suivante
+    //  Les lignes de A^(2^(k+1)) sont écrites pendant l'étape suivante si un checkpoint est prévu
+    for(int k = first; k < steps && changed; k++)
     {
-        for (int c = 0; c < m; c++)
-        {
-            long min = LONG_MAX, curr;
-            for (int i = 0; i < p; i++)
-            {
-                if(get(m1,r,i) == LONG_MAX || get(m2,i,c) == LONG_MAX) curr = LONG_MAX;
-                else curr = get(m1,r,i)+get(m2,i,c);
-                min = min<curr ? min:curr;
-            }
-            set(res,r,c,min);
-        }
+        c = process(a,b,ws,paths,rank,numprocs);
+        changed = !equals(a,c);
+        MPI_Allreduce(MPI_IN_PLACE, &changed, 1, MPI_INT, MPI_LOR, MPI_COMM_WORLD);
+        a = c;
+        finish_checkpoint(cp, rank);
+        if(changed && k + 1 < steps) redistribute(a,b,ws,rank,numprocs);
+        if(changed && k + 1 < steps && paths != NULL) redistribute(paths->a,paths->b,&paths->ws,rank,numprocs);
+        if(changed && checkpoint_due(cp, k + 1, steps)) start_checkpoint(cp, a->array, a->height, N, k + 1, rank, numprocs);
     }
-    return res;
+    return a;
 }
 
 
-void replace(Matrix *a, Matrix *b, int row, int column)
+void update(Matrix *a, Paths *paths, long *row, long u, long v, long w, MPI_Comm comm)
 {
-    //remplace aux coordonnées row colums et aux suivantes les valeurs de a par celles de b 
-    int n=b->height, m=b->width;
-    #pragma omp parallel for
-    for(int rb=0; rb < n; rb++)
-    {   
-        for(int cb = 0; cb < m; cb++)
+    int rank, numprocs, owner, h = a->height, N = a->width, length = paths == NULL ? N : 2*N;
+    long *prow = row + N, first;
+
+    //la machine qui possède la ligne v la transmet à toutes les autres, suivie de ses prédécesseurs
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &numprocs);
+    owner = OWNER(v, numprocs, N);
+    first = FIRST(owner, numprocs, N);
+    if(rank == owner) memcpy(row, a->array + (v - first)*N, N*sizeof(long));
+    if(rank == owner && paths != NULL) memcpy(prow, paths->a->array + (v - first)*N, N*sizeof(long));
+    MPI_Bcast(row, length, MPI_LONG, owner, comm);
+
+    //d[i][j] = min(d[i][j], d[i][u] + w + d[v][j]) sur chaque ligne i de la machine
+    //seules les lignes dont le chemin vers v raccourcit peuvent changer, les autres sont ignorées
+    #pragma omp parallel for schedule(dynamic, 16)
+    for(int r = 0; r < h; r++)
+    {
+        long *d = a->array + (long) r*N, *p = paths == NULL ? NULL : paths->a->array + (long) r*N;
+        long t = d[u] + w;
+        if(t >= d[v]) continue;
+        for(int j = 0; j < N; j++)
         {
-            set(a, rb+row, cb+column, get(b,rb,cb));
+            long s = CLAMP(t + row[j]);
+            if(s >= d[j]) continue;
+            d[j] = s;
+            if(p != NULL) p[j] = j == v ? u : prow[j];
         }
     }
 }
 
 
-
-
-//-----------------------------------------------------------------
-//----------------------------UTILS--------------------------------
-//-----------------------------------------------------------------
-void set(Matrix *matrix, int row, int column, long value)
+Matrix *solve(Matrix *a, Matrix *b, Workspace *ws, Paths *paths, Options *options, int N, int rank, int numprocs)
 {
-    //change la valeur aux coordonnées row column
-    //la position dans la memoire est determinée en foction de l'optimisation
-    if(matrix->row_opti) matrix->array[row*matrix->width+column]=value;
-    else matrix->array[column*matrix->height+row]=value;
-}
+    Checkpoint cp = create_checkpoint(paths == NULL ? options : NULL, a);
+    int element, first;
 
-long get(Matrix *matrix, int row, int column)
-{
-    //retourne la valeur aux coordonnées row column
-    //la position dans la memoire est determinée en foction de l'optimisation
-    if(matrix->row_opti) return matrix->array[row*matrix->width+column];
-    else return matrix->array[column*matrix->height+row];
-}
+    //si le plus long chemin possible le permet les blocs sont convertis dans un type plus petit
+    //avec -e none les lignes contiennent déjà les distances, par exemple le résultat d'un calcul précédent
+    //le type est choisi sur le graphe avant la reprise : les distances d'un checkpoint ne bornent pas ses arcs
+    element = paths == NULL && options->engine != ENGINE_NONE ? select_element(a, N, options->element, MPI_COMM_WORLD) : ELEMENT_LONG;
 
-int size(Matrix *matrix)
-{
-    //retourne le nombre de données dans la matrice
-    return matrix->width*matrix->height;
-}
+    //la reprise ne vaut que pour le premier calcul, un reload du mode service recommence au début
+    first = options->restart ? resume(&cp, a, b, options->engine, N, rank, numprocs) : 0;
+    options->restart = false;
 
-void display_matrix(Matrix *m)
-{
-    int Nlimit;
-    //créer un délimiteur pour ne pas afficher les colonnes et lignes qui ont été ajoutées pour s'adapter au nombre de processeurs
-    for(Nlimit = 0; Nlimit < m->height && get(m, Nlimit, Nlimit) != LONG_MAX; Nlimit++);
-    
-    //affiche la matrice ligne par ligne avec chaque valeur séparées par une espace
-    for(int r = 0; r < Nlimit; r++)
+    if(element == ELEMENT_UINT16) a = compute_uint16(a,b,ws,&cp,first,N,options->engine,rank,numprocs);
+    else if(element == ELEMENT_INT32) a = compute_int32(a,b,ws,&cp,first,N,options->engine,rank,numprocs);
+    else if(options->engine == ENGINE_RING)
     {
-        for(int c = 0; c < Nlimit; c++)
+        for(int i = first; i < N; i++)
         {
-            if(get(m,r,c) == LONG_MAX) printf("%c ", 'i');
-            else printf("%ld ", get(m,r,c));
+            a = process(a,b,ws,paths,rank,numprocs);
+            finish_checkpoint(&cp, rank);
+            if(checkpoint_due(&cp, i + 1, N)) start_checkpoint(&cp, a->array, a->height, N, i + 1, rank, numprocs);
         }
-        printf("\n");
     }
+    else if(options->engine == ENGINE_SQUARE) a = square(a,b,ws,paths,&cp,first,N,rank,numprocs);
+    free_checkpoint(&cp, rank);
+    return a;
 }
 
-void display_array(long *array, int size)
+
+int load_rows(char *path, Matrix **a, Matrix **b, int rank, int numprocs)
 {
-    for(int i = 0; i < size; i++)
+    Header header;
+    Matrix *A = NULL;
+    int N = 0;
+
+    //un fichier binaire est lu en parallele, sinon l'emmeteur le lit et le répartit avec les collectives
+    if(read_header(path, &header) == 0)
     {
-        printf("%5ld ", array[i]);        
+        N = header.size;
+        *b = load_block(path, &header, 0, FIRST(rank, numprocs, N), N, PART(rank, numprocs, N), false, MPI_COMM_WORLD);
+        *a = load_block(path, &header, FIRST(rank, numprocs, N), 0, PART(rank, numprocs, N), N, true, MPI_COMM_WORLD);
+        return N;
     }
-    printf("\n");
+    if(rank == TRANSMITTER)
+    {
+        A = load_matrix(path);
+        N = A->height;
+    }
+    N = broadcast_collective(N, TRANSMITTER);
+    *b = scatter_collective(A, N, false, TRANSMITTER, rank, numprocs);
+    *a = scatter_collective(A, N, true, TRANSMITTER, rank, numprocs);
+    if(rank == TRANSMITTER) free(A->array);
+    if(rank == TRANSMITTER) free(A);
+    return N;
 }
 
-//-----------------------------------------------------------------
-//--------------------CREATION DE MATRICES-------------------------
-//-----------------------------------------------------------------
-Matrix *generate_matrix(long *data, int h, int w, bool row_opti)
-{
-    //génere une matrice en mémoire avec les données data
-    Matrix *m = (Matrix *) malloc(sizeof(Matrix));
-    m->height=h;
-    m->width=w;
-    m->row_opti=row_opti;
-    m->array = data;
-    return m;
-}
 
-Matrix *create_matrix(int seed, int h, int w, bool row_opti)
+void serve(Matrix *a, Matrix *b, Workspace *ws, Paths *paths, Options *options, int N, int rank, int numprocs)
 {
-    //créer une matrice avec des valeurs tests
-    Matrix *m = generate_matrix((long *) malloc(h*w*sizeof(long)), h,w,row_opti);
-    int i = seed+1;
+    Command command;
+    long *row = (long *) malloc(N*sizeof(long)), *prow = (long *) malloc(N*sizeof(long));
+    char value[24];
+    int *nodes = (int *) malloc(N*sizeof(int)), count;
 
-    for(int r = 0; r < m->height; r++)
+    //l'emmeteur lit chaque commande et la transmet, toutes les machines l'exécutent ensemble
+    //une requete ne rapatrie que la ligne demandée depuis la machine qui la possède
+    if(rank == TRANSMITTER) printf("ready %d\n", N);
+    do
     {
-        for(int c = 0; c < m->width; c++)
+        if(rank == TRANSMITTER)
+        {
+            fflush(stdout);
+            while(read_command(&command))
+            {
+                printf("error\n");
+                fflush(stdout);
+            }
+        }
+        MPI_Bcast(&command, sizeof(Command), MPI_BYTE, TRANSMITTER, MPI_COMM_WORLD);
+
+        switch(command.type)
+        {
+            case COMMAND_DIST:
+            case COMMAND_ROW:
+                if(command.args[0] >= N || (command.type == COMMAND_DIST && command.args[1] >= N))
+                {
+                    if(rank == TRANSMITTER) printf("error\n");
+                    break;
+                }
+                fetch_row(a, command.args[0], row, rank, numprocs);
+                if(rank == TRANSMITTER && command.type == COMMAND_DIST)
+                {
+                    value[format_value(row[command.args[1]], value)] = '\0';
+                    printf("%s\n", value);
+                }
+                for(int j = 0; rank == TRANSMITTER && command.type == COMMAND_ROW && j < N; j++)
+                {
+                    value[format_value(row[j], value)] = '\0';
+                    printf(j + 1 < N ? "%s " : "%s\n", value);
+                }
+                break;
+
+            case COMMAND_PATH:
+                if(paths == NULL || command.args[0] >= N || command.args[1] >= N)
+                {
+                    if(rank == TRANSMITTER) printf("error\n");
+                    break;
+                }
+                fetch_row(paths->a, command.args[0], prow, rank, numprocs);
+                if(rank == TRANSMITTER) display_path(prow, N, command.args[0], command.args[1]);
+                break;
+
+            case COMMAND_UPDATE:
+                count = apply_updates(a, paths, command.args, 1, MPI_COMM_WORLD);
+                if(rank == TRANSMITTER) printf(count == 0 ? "ok\n" : "error\n");
+                break;
+
+            case COMMAND_RELOAD:
+                //le nouveau graphe remplace toutes les matrices et les tampons
+                if(paths != NULL) free_paths(paths);
+                free_workspace(ws);
+                free(a);
+                free(b);
+                N = load_rows(command.path, &a, &b, rank, numprocs);
+                if(paths != NULL) *paths = create_paths(a, b, rank, numprocs);
+                *ws = create_workspace(a, b, numprocs);
+                a = solve(a, b, ws, paths, options, N, rank, numprocs);
+                row = (long *) realloc(row, N*sizeof(long));
+                prow = (long *) realloc(prow, N*sizeof(long));
+                nodes = (int *) realloc(nodes, N*sizeof(int));
+                if(rank == TRANSMITTER) printf("ready %d\n", N);
+                break;
+
+            case COMMAND_CHECKPOINT:
+                //les distances sont écrites au format binaire, -e none les recharge sans recalculer
+                count = write_rows(command.path, a, FIRST(rank, numprocs, N), N, true, MPI_COMM_WORLD);
+                if(rank == TRANSMITTER) printf(count == 0 ? "ok\n" : "error\n");
+                break;
+        }
+    } while(command.type != COMMAND_QUIT);
+
+    if(paths != NULL) free_paths(paths);
+    free_workspace(ws);
+    free(a);
+    free(b);
+    free(row);
+    free(prow);
+    free(nodes);
+}
+
+
+int read_command(Command *command)
+{
+    char line[COMMAND_PATH_LENGTH + 32], name[16];
+    int read;
+    FILE *file;
+
+    //la fin de l'entrée standard arrete le service
+    memset(command, 0, sizeof(Command));
+    command->type = COMMAND_QUIT;
+    if(fgets(line, sizeof(line), stdin) == NULL) return 0;
+
+    command->type = COMMAND_INVALID;
+    if(sscanf(line, "%15s", name) != 1) return 1;
+    read = sscanf(line, "%*s %ld %ld %ld", &command->args[0], &command->args[1], &command->args[2]);
+    if(strcmp(name, "dist") == 0 && read == 2) command->type = COMMAND_DIST;
+    else if(strcmp(name, "row") == 0 && read == 1) command->type = COMMAND_ROW;
+    else if(strcmp(name, "path") == 0 && read == 2) command->type = COMMAND_PATH;
+    else if(strcmp(name, "update") == 0 && read == 3) command->type = COMMAND_UPDATE;
+    else if(strcmp(name, "quit") == 0) command->type = COMMAND_QUIT;
+    else if((strcmp(name, "reload") == 0 || strcmp(name, "checkpoint") == 0) && sscanf(line, "%*s %255s", command->path) == 1)
+    {
+        command->type = strcmp(name, "reload") == 0 ? COMMAND_RELOAD : COMMAND_CHECKPOINT;
+    }
+
+    //un fichier à recharger doit exister, sinon toutes les machines attendraient un graphe absent
+    if(command->type == COMMAND_RELOAD && (file = fopen(command->path, "r")) == NULL) command->type = COMMAND_INVALID;
+    else if(command->type == COMMAND_RELOAD) fclose(file);
+    if(command->args[0] < 0 || command->args[1] < 0) command->type = COMMAND_INVALID;
+    return command->type == COMMAND_INVALID;
+}
+
+
+int hybrid_threads(void)
+{
+    MPI_Comm node;
+    int local, procs = omp_get_num_procs(), total, threads, rank;
+
+    //les rangs qui partagent la mémoire du noeud, omp_get_num_procs ne compte que les coeurs auxquels le rang est attaché
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &node);
+    MPI_Comm_size(node, &local);
+    MPI_Allreduce(&procs, &total, 1, MPI_INT, MPI_SUM, node);
+    MPI_Comm_free(&node);
+
+    //attachés chacun à leur socket (--bind-to socket) les rangs gardent leurs coeurs,
+    //sinon ils voient tous les coeurs du noeud et se les partagent ; OMP_NUM_THREADS reste prioritaire
+    threads = total <= sysconf(_SC_NPROCESSORS_ONLN) ? procs : procs / local;
+    if(threads < 1) threads = 1;
+    if(getenv("OMP_NUM_THREADS") == NULL) omp_set_num_threads(threads);
+
+    //les places sont lues par OpenMP au lancement et ne peuvent plus etre fixées ici :
+    //sans OMP_PLACES (ni OMP_PROC_BIND) les threads ne sont attachés à aucun coeur et proc_bind(close) n'a pas d'effet
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    if(rank == TRANSMITTER && omp_get_num_places() == 0) fprintf(stderr, "OMP_PLACES is not set, OpenMP threads are not pinned (run with OMP_PLACES=cores OMP_PROC_BIND=close)\n");
+    return omp_get_max_threads();
+}
+
+
+int thread_slot(int *places)
+{
+    int t = omp_get_thread_num(), threads = omp_get_num_threads(), slot = 0;
+
+    //les threads sont rangés par place puis par numéro : les memes lignes reviennent au meme coeur dans chaque région,
+    //meme si l'équipe n'y attache pas ses threads dans le meme ordre ; sans places l'ordre est celui des numéros
+    places[t] = omp_get_place_num();
+    #pragma omp barrier
+    for(int i = 0; i < threads; i++) slot += places[i] < places[t] || (places[i] == places[t] && i < t);
+    #pragma omp barrier
+    return slot;
+}
+
+
+long *fetch_row(Matrix *a, int i, long *row, int rank, int numprocs)
+{
+    int owner = OWNER(i, numprocs, a->width);
+    long *local = a->array + (long) (i - FIRST(owner, numprocs, a->width))*a->width;
+
+    //seule la machine qui possède la ligne l'envoie, l'emmeteur la copie directement si elle est chez lui
+    if(rank == owner && rank == TRANSMITTER) memcpy(row, local, a->width*sizeof(long));
+    else if(rank == owner) MPI_Send(local, a->width, MPI_LONG, TRANSMITTER, SERVICE, MPI_COMM_WORLD);
+    else if(rank == TRANSMITTER) MPI_Recv(row, a->width, MPI_LONG, owner, SERVICE, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    return row;
+}
+
+
+int apply_updates(Matrix *a, Paths *paths, long *updates, int count, MPI_Comm comm)
+{
+    long *row = (long *) malloc(2*a->width*sizeof(long));
+    int ignored = 0, n = a->width;
+
+    //les arcs sont appliqués dans l'ordre, un arc hors de la matrice, de poids négatif ou infini est ignoré
+    for(int k = 0; k < count; k++)
+    {
+        long u = updates[3*k], v = updates[3*k+1], w = updates[3*k+2];
+        if(u < 0 || v < 0 || u >= n || v >= n || w < 0 || w >= INF) ignored++;
+        else update(a, paths, row, u, v, w, comm);
+    }
+    free(row);
+    return ignored;
+}
+
+
+void redistribute(Matrix *a, Matrix *b, Workspace *ws, int rank, int numprocs)
+{
+    MPI_Status status;
+    int N = a->width;
+    Matrix *out = ws->out, *in = ws->in;
+    double start, received;
+
+    //A l'étape s on envoie à la machine rank+s l'intersection de nos lignes et de ses colonnes
+    //et on recoit de la machine rank-s l'intersection de ses lignes et de nos colonnes
+    //les tampons prennent la taille de chaque intersection, les parts n'étant pas toutes égales
+    for(int s = 0; s < numprocs; s++)
+    {
+        int dest = CURRENT(rank+s, numprocs), src = CURRENT(rank-s, numprocs);
+        out->height = a->height;
+        out->width = PART(dest, numprocs, N);
+        in->height = PART(src, numprocs, N);
+        in->width = b->width;
+        start = trace_start();
+        extract(a, out, 0, FIRST(dest, numprocs, N));
+        MPI_Sendrecv(out->array, size(out), MPI_LONG, dest, REDISTRIBUTE, in->array, size(in), MPI_LONG, src, REDISTRIBUTE, MPI_COMM_WORLD, &status);
+        received = src != rank ? size(in) * sizeof(long) : 0;
+        counters.bytes += received;
+        trace_stop(EVENT_REDISTRIBUTE, start, received);
+        replace(b, in, FIRST(src, numprocs, N), 0);
+    }
+}
+
+
+
+
+//-----------------------------------------------------------------
+//-------------------------MODE BENCHMARK--------------------------
+//-----------------------------------------------------------------
+//Chaque mesure génere un graphe chez l'emmeteur puis suit le meme parcours que main : répartition, calcul,
+//assemblage et écriture. Les phases sont séparées par une barrière, leur durée est celle de la machine la plus lente.
+//Le nombre de machines ne change pas pendant l'exécution, une étude de passage à l'échelle relance le programme.
+void benchmark(Options *options, int rank, int numprocs)
+{
+    char *generators[] = {"", "dense", "er", "grid"};
+    char *engines[] = {"", "ring", "square", "floyd", "none", "sparse", "auto", "summa", "shared"};
+    char *elements[] = {"auto", "long", "int32", "uint16"};
+    char *names[] = {"load", "scatter", "compute", "gather", "output"};
+    int N, M, engine, element, nb_threads = options->nb_threads > 0 ? options->nb_threads : 1;
+    long edges = 0;
+    double operations;
+    Matrix *A, *B, *a, *b = NULL, *stripe;
+    Options run = *options;
+    Workspace ws;
+    Graph *g, shape;
+    Phases phases;
+    Grid grid = create_grid(MPI_COMM_WORLD);
+
+    //comme dans main, les tuiles de la grille restent en long et les mesures indiquent long
+    if(rank == TRANSMITTER && (options->engine == ENGINE_FLOYD || options->engine == ENGINE_SUMMA || (options->engine == ENGINE_SHARED && numprocs > 1))
+        && (options->element == ELEMENT_INT32 || options->element == ELEMENT_UINT16)) fprintf(stderr, "-t is not supported by the floyd and summa engines, computing in long\n");
+
+    if(rank == TRANSMITTER) printf("{\n  \"generator\": \"%s\", \"seed\": %ld, \"density\": %g, \"ranks\": %d,\n  \"runs\": [", generators[options->generator], options->seed, options->density, numprocs);
+
+    for(int s = 0; s < options->nb_sizes; s++)
+    {
+        for(int t = 0; t < nb_threads; t++)
+        {
+            N = options->sizes[s];
+            if(options->nb_threads > 0) omp_set_num_threads(options->threads[t]);
+            A = B = NULL;
+            element = ELEMENT_LONG;
+            counters.operations = 0;
+            MPI_Barrier(MPI_COMM_WORLD);
+            phases.start = MPI_Wtime();
+            phases.mark = counters.bytes;
+
+            //l'emmeteur génere le graphe, son nombre d'arcs suffit pour choisir le moteur automatiquement
+            if(rank == TRANSMITTER) A = generate_graph(options->generator, N, options->density, options->seed, &edges);
+            MPI_Bcast(&edges, 1, MPI_LONG, TRANSMITTER, MPI_COMM_WORLD);
+            shape.n = N;
+            shape.edges = edges;
+            shape.negative = false;
+            engine = run.engine = options->engine == ENGINE_AUTO ? select_engine(&shape, options) : options->engine;
+            if(engine == ENGINE_SHARED && numprocs > 1) engine = run.engine = ENGINE_FLOYD;
+            lap(&phases, PHASE_LOAD);
+
+            if(engine == ENGINE_SHARED)
+            {
+                //comme dans main, la matrice générée est calculée sur place
+                element = select_element(A, N, options->element, MPI_COMM_SELF);
+                lap(&phases, PHASE_SCATTER);
+                floyd_shared(A, element);
+                lap(&phases, PHASE_COMPUTE);
+                lap(&phases, PHASE_GATHER);
+                if(options->output != NULL) write_rows(options->output, A, 0, N, options->binary_output, MPI_COMM_WORLD);
+                lap(&phases, PHASE_OUTPUT);
+            }
+            else if(engine == ENGINE_FLOYD || engine == ENGINE_SUMMA)
+            {
+                //comme dans main, seule la grille complète la matrice à M sommets
+                M = adjust(N, numprocs);
+                a = scatter_grid(A, M, &grid, TRANSMITTER);
+                lap(&phases, PHASE_SCATTER);
+                if(engine == ENGINE_FLOYD) floyd(a, M, &grid);
+                else summa(a, M, &grid);
+                lap(&phases, PHASE_COMPUTE);
+                B = gather_grid(a, N, &grid, TRANSMITTER);
+                lap(&phases, PHASE_GATHER);
+                if(options->output != NULL)
+                {
+                    stripe = gather_row_tiles(a, M, &grid);
+                    write_rows(options->output, stripe, grid.row*(M/grid.rows), N, options->binary_output, MPI_COMM_WORLD);
+                    if(stripe != NULL) free(stripe->array);
+                    free(stripe);
+                }
+                lap(&phases, PHASE_OUTPUT);
+                free(a->array);
+                free(a);
+            }
+            else
+            {
+                //le moteur creux reconstruit le graphe complet à partir des lignes de chaque machine
+                if(engine == ENGINE_SPARSE)
+                {
+                    a = scatter_collective(A, N, true, TRANSMITTER, rank, numprocs);
+                    g = graph_from_rows(a, MPI_COMM_WORLD);
+                    free(a->array);
+                    free(a);
+                    lap(&phases, PHASE_SCATTER);
+                    a = sparse(g, rank, numprocs);
+                    free_graph(g);
+                    lap(&phases, PHASE_COMPUTE);
+                }
+                else
+                {
+                    if(options->distribution == DISTRIBUTION_COLLECTIVE)
+                    {
+                        b = scatter_collective(A, N, false, TRANSMITTER, rank, numprocs);
+                        a = scatter_collective(A, N, true, TRANSMITTER, rank, numprocs);
+                    }
+                    else
+                    {
+                        b = scatter(A, N, false, TRANSMITTER, rank, numprocs);
+                        a = scatter(A, N, true, TRANSMITTER, rank, numprocs);
+                    }
+                    ws = create_workspace(a, b, numprocs);
+                    if(engine != ENGINE_NONE) element = select_element(a, N, options->element, MPI_COMM_WORLD);
+                    lap(&phases, PHASE_SCATTER);
+                    a = solve(a, b, &ws, NULL, &run, N, rank, numprocs);
+                    lap(&phases, PHASE_COMPUTE);
+                }
+
+                if(options->distribution == DISTRIBUTION_COLLECTIVE) B = gather_collective(TRANSMITTER, rank, numprocs, a);
+                else B = gather(TRANSMITTER, rank, numprocs, a);
+                lap(&phases, PHASE_GATHER);
+                if(options->output != NULL) write_rows(options->output, a, FIRST(rank, numprocs, N), N, options->binary_output, MPI_COMM_WORLD);
+                lap(&phases, PHASE_OUTPUT);
+
+                if(engine == ENGINE_SPARSE) free(a->array);
+                else free_workspace(&ws);
+                if(engine != ENGINE_SPARSE) free(b);
+                free(a);
+            }
+
+            //les octets et les opérations de toutes les machines sont additionnés chez l'emmeteur
+            operations = counters.operations;
+            MPI_Reduce(rank == TRANSMITTER ? MPI_IN_PLACE : phases.bytes, phases.bytes, PHASES, MPI_DOUBLE, MPI_SUM, TRANSMITTER, MPI_COMM_WORLD);
+            MPI_Reduce(rank == TRANSMITTER ? MPI_IN_PLACE : &operations, &operations, 1, MPI_DOUBLE, MPI_SUM, TRANSMITTER, MPI_COMM_WORLD);
+
+            //une opération min-plus compte pour deux opérations flottantes, une addition et un minimum
+            if(rank == TRANSMITTER)
+            {
+                printf("%s\n    {\"n\": %d, \"threads\": %d, \"edges\": %ld, \"engine\": \"%s\", \"element\": \"%s\",\n     \"time\": {", s + t > 0 ? "," : "", N, omp_get_max_threads(), edges, engines[engine], elements[element]);
+                for(int p = 0; p < PHASES; p++) printf("%s\"%s\": %.6f", p > 0 ? ", " : "", names[p], phases.time[p]);
+                printf("},\n     \"bytes\": {");
+                for(int p = 0; p < PHASES; p++) printf("%s\"%s\": %.0f", p > 0 ? ", " : "", names[p], phases.bytes[p]);
+                printf("},\n     \"operations\": %.0f, \"gflops\": %.3f}", operations, phases.time[PHASE_COMPUTE] > 0 ? 2 * operations / phases.time[PHASE_COMPUTE] / 1e9 : 0);
+                fflush(stdout);
+            }
+
+            if(A != NULL) free(A->array);
+            if(B != NULL) free(B->array);
+            free(A);
+            free(B);
+        }
+    }
+    if(rank == TRANSMITTER) printf("\n  ]\n}\n");
+
+    MPI_Comm_free(&grid.row_comm);
+    MPI_Comm_free(&grid.column_comm);
+    MPI_Comm_free(&grid.comm);
+}
+
+
+Matrix *generate_graph(int generator, int N, double density, long seed, long *edges)
+{
+    Matrix *m = generate_matrix((long *) malloc((long) N*N*sizeof(long)), N, N, true);
+    int side = 1;
+    long count = 0;
+
+    //le générateur grid place les sommets ligne par ligne sur une grille de side colonnes, reliés à leurs 4 voisins
+    while(side * side < N) side++;
+
+    //comme data_generation.py les poids vont de 1 à 100, la diagonale est nulle et l'absence d'arc est l'infini
+    //chaque ligne a son propre état aléatoire, le graphe ne dépend que de la graine et pas du nombre de threads
+    #pragma omp parallel for schedule(static) proc_bind(close) reduction(+:count)
+    for(int r = 0; r < N; r++)
+    {
+        uint64_t state = ((uint64_t) seed << 32) ^ (uint64_t) r;
+        long *row = m->array + (long) r*N;
+        for(int c = 0; c < N; c++)
+        {
+            bool arc;
+            if(generator == GENERATOR_DENSE) arc = true;
+            else if(generator == GENERATOR_ER) arc = (next_random(&state) >> 11) * 0x1.0p-53 < density;
+            else arc = (c == r + 1 && c % side != 0) || (r == c + 1 && r % side != 0) || c == r + side || r == c + side;
+            row[c] = 1 + (long) (next_random(&state) % 100);
+            if(r == c) row[c] = 0;
+            else if(!arc) row[c] = INF;
+            else count++;
+        }
+    }
+    *edges = count;
+    return m;
+}
+
+
+uint64_t next_random(uint64_t *state)
+{
+    //splitmix64
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+
+void lap(Phases *phases, int phase)
+{
+    double now;
+
+    //la phase est terminée quand toutes les machines l'ont terminée
+    MPI_Barrier(MPI_COMM_WORLD);
+    now = MPI_Wtime();
+    phases->time[phase] = now - phases->start;
+    phases->bytes[phase] = counters.bytes - phases->mark;
+    trace_stop(phase, phases->start, phases->bytes[phase]);
+    phases->start = now;
+    phases->mark = counters.bytes;
+}
+
+
+
+
+//-----------------------------------------------------------------
+//---------------------------MODE BATCH----------------------------
+//-----------------------------------------------------------------
+//Chaque graphe du manifeste est résolu en entier par une seule machine avec floyd_shared, sans message pendant le calcul.
+//Les graphes sont triés du plus gros au plus petit et un compteur chez l'emmeteur donne le suivant à la machine qui
+//le demande : les gros graphes partent en premier et les petits comblent les machines qui ont fini.
+void batch(Options *options, int rank, int numprocs)
+{
+    MPI_Win win;
+    Entry *entries = NULL;
+    int *next, one = 1, index, count = 0;
+    double start, stats[3] = {0, 0, 0}, *all = NULL;
+
+    //l'emmeteur lit et trie le manifeste, toutes les machines en recoivent une copie
+    if(rank == TRANSMITTER) entries = read_manifest(options->manifest, &count);
+    MPI_Bcast(&count, 1, MPI_INT, TRANSMITTER, MPI_COMM_WORLD);
+    if(count < 0)
+    {
+        if(rank == TRANSMITTER) printf("Manifest %s can't be read... exit\n", options->manifest);
+        return;
+    }
+    if(rank != TRANSMITTER) entries = (Entry *) malloc((count > 0 ? count : 1)*sizeof(Entry));
+    MPI_Bcast(entries, count*sizeof(Entry), MPI_BYTE, TRANSMITTER, MPI_COMM_WORLD);
+
+    //indice du prochain graphe, chaque machine le lit et l'incrémente en une seule opération atomique
+    MPI_Win_allocate(rank == TRANSMITTER ? sizeof(int) : 0, sizeof(int), MPI_INFO_NULL, MPI_COMM_WORLD, &next, &win);
+    if(rank == TRANSMITTER)
+    {
+        MPI_Win_lock(MPI_LOCK_EXCLUSIVE, TRANSMITTER, 0, win);
+        *next = 0;
+        MPI_Win_unlock(TRANSMITTER, win);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    //stats : graphes résolus, graphes en échec et temps de calcul de la machine
+    MPI_Win_lock_all(0, win);
+    while(true)
+    {
+        MPI_Fetch_and_op(&one, &index, MPI_INT, TRANSMITTER, 0, MPI_SUM, win);
+        MPI_Win_flush(TRANSMITTER, win);
+        if(index >= count) break;
+        start = MPI_Wtime();
+        if(solve_graph(&entries[index], options) < 0)
+        {
+            printf("Graph %s failed\n", entries[index].data);
+            stats[1]++;
+        }
+        else stats[0]++;
+        stats[2] += MPI_Wtime() - start;
+    }
+    MPI_Win_unlock_all(win);
+    MPI_Win_free(&win);
+
+    //l'emmeteur affiche la charge de chaque machine
+    if(rank == TRANSMITTER) all = (double *) malloc(3*numprocs*sizeof(double));
+    MPI_Gather(stats, 3, MPI_DOUBLE, all, 3, MPI_DOUBLE, TRANSMITTER, MPI_COMM_WORLD);
+    for(int p = 0; rank == TRANSMITTER && p < numprocs; p++) printf("rank %d : %.0f graphs, %.0f failed, %.3f s\n", p, all[3*p], all[3*p+1], all[3*p+2]);
+    free(all);
+    free(entries);
+}
+
+
+Entry *read_manifest(char *path, int *count)
+{
+    FILE *file = fopen(path, "r"), *data;
+    Entry *entries = NULL;
+    char line[2*COMMAND_PATH_LENGTH + 2];
+    int fields;
+
+    *count = -1;
+    if(file == NULL) return NULL;
+
+    //une ligne par graphe : fichier de données puis fichier résultat facultatif, les lignes vides et # sont ignorées
+    *count = 0;
+    while(fgets(line, sizeof(line), file) != NULL)
+    {
+        entries = (Entry *) realloc(entries, (*count + 1)*sizeof(Entry));
+        fields = sscanf(line, " %255s %255s", entries[*count].data, entries[*count].output);
+        if(fields < 1 || entries[*count].data[0] == '#') continue;
+        if(fields < 2) sprintf(entries[*count].output, "%s.out", entries[*count].data);
+
+        //un fichier absent est gardé, son échec sera signalé par la machine qui le prend
+        entries[*count].bytes = 0;
+        data = fopen(entries[*count].data, "rb");
+        if(data != NULL && fseek(data, 0, SEEK_END) == 0) entries[*count].bytes = ftell(data);
+        if(data != NULL) fclose(data);
+        (*count)++;
+    }
+    fclose(file);
+    qsort(entries, *count, sizeof(Entry), compare_entries);
+    return entries;
+}
+
+
+int compare_entries(const void *a, const void *b)
+{
+    long x = ((const Entry *) a)->bytes, y = ((const Entry *) b)->bytes;
+    return x < y ? 1 : (x > y ? -1 : 0);
+}
+
+
+int solve_graph(Entry *entry, Options *options)
+{
+    Header header;
+    Matrix *m;
+    int N;
+
+    //la machine lit seule tout le graphe, un fichier binaire avec MPI-IO sur MPI_COMM_SELF
+    if(read_header(entry->data, &header) == 0) m = load_block(entry->data, &header, 0, 0, header.size, header.size, true, MPI_COMM_SELF);
+    else m = load_matrix(entry->data);
+    if(m == NULL) return -1;
+
+    //meme calcul que le moteur shared, le résultat est écrit dès qu'il est prêt
+    N = m->height;
+    if(N > 0) floyd_shared(m, options->element);
+    if(write_rows(entry->output, m, 0, N, options->binary_output, MPI_COMM_SELF)) N = -1;
+    free(m->array);
+    free(m);
+    return N;
+}
+
+
+
+
+//-----------------------------------------------------------------
+//------------------------------TRACE------------------------------
+//-----------------------------------------------------------------
+//Avec -T chaque machine note le début, la durée et les octets de ses phases, de chaque étape de l'anneau
+//(calcul et attente séparés), des relais de scatter et gather et des diffusions de Floyd-Warshall.
+//Sans -T chaque point de mesure ne coute qu'un test, avec -T deux appels à MPI_Wtime.
+void open_trace(void)
+{
+    memset(&trace, 0, sizeof(Trace));
+    trace.enabled = true;
+    trace.capacity = 4096;
+    trace.events = (Event *) malloc(trace.capacity*sizeof(Event));
+
+    //les traces des machines partent du meme instant et se superposent dans le visualiseur
+    MPI_Barrier(MPI_COMM_WORLD);
+    trace.origin = trace.phase = MPI_Wtime();
+    trace.mark = counters.bytes;
+}
+
+
+double trace_start(void)
+{
+    return trace.enabled ? MPI_Wtime() : 0;
+}
+
+
+void trace_stop(int type, double start, double bytes)
+{
+    double now;
+
+    if(!trace.enabled) return;
+    now = MPI_Wtime();
+    trace.total[type] += now - start;
+    trace.bytes[type] += bytes;
+    trace.calls[type]++;
+
+    //le tableau grandit jusqu'à TRACE_CAPACITY, les événements suivants ne sont plus que comptés
+    if(trace.count == trace.capacity && trace.capacity < TRACE_CAPACITY)
+    {
+        trace.capacity *= 2;
+        trace.events = (Event *) realloc(trace.events, trace.capacity*sizeof(Event));
+    }
+    if(trace.count == trace.capacity)
+    {
+        trace.dropped++;
+        return;
+    }
+    trace.events[trace.count].type = type;
+    trace.events[trace.count].start = start - trace.origin;
+    trace.events[trace.count].duration = now - start;
+    trace.events[trace.count++].bytes = bytes;
+}
+
+
+void trace_phase(int phase)
+{
+    if(!trace.enabled) return;
+    trace_stop(phase, trace.phase, counters.bytes - trace.mark);
+    trace.phase = MPI_Wtime();
+    trace.mark = counters.bytes;
+}
+
+
+void close_trace(char *prefix, int rank, int numprocs)
+{
+    char *names[] = {"load", "scatter", "compute", "gather", "output", "ring compute", "ring wait", "redistribute", "relay", "distribute", "floyd compute", "floyd broadcast", "dijkstra", "checkpoint", "summa compute", "summa wait"};
+    char *path;
+    FILE *file;
+    struct { double value; int rank; } local[EVENTS], slowest[EVENTS];
+    double fastest[EVENTS], sum[EVENTS], bytes[EVENTS], max_bytes[EVENTS], calls[EVENTS];
+
+    if(prefix == NULL || !trace.enabled) return;
+    trace.enabled = false;
+
+    //une trace au format Chrome (chrome://tracing, Perfetto) par machine, chaque machine y est un processus
+    path = (char *) malloc(strlen(prefix) + 32);
+    sprintf(path, "%s.%d.json", prefix, rank);
+    file = fopen(path, "w");
+    if(file != NULL)
+    {
+        fprintf(file, "{\"traceEvents\": [\n");
+        fprintf(file, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %d, \"args\": {\"name\": \"rank %d\"}}", rank, rank);
+        for(long e = 0; e < trace.count; e++)
+        {
+            Event *event = trace.events + e;
+            fprintf(file, ",\n{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"pid\": %d, \"tid\": 0, \"ts\": %.3f, \"dur\": %.3f, \"args\": {\"bytes\": %.0f}}",
+                    names[event->type], event->type < PHASES ? "phase" : "step", rank, event->start*1e6, event->duration*1e6, event->bytes);
+        }
+        fprintf(file, "\n], \"displayTimeUnit\": \"ms\", \"otherData\": {\"rank\": %d, \"ranks\": %d, \"dropped\": %ld}}\n", rank, numprocs, trace.dropped);
+        fclose(file);
+    }
+    else fprintf(stderr, "Trace file %s cannot be written\n", path);
+    free(path);
+    free(trace.events);
+
+    //temps minimum, moyen et maximum de chaque type sur les machines, avec la machine la plus lente
+    for(int t = 0; t < EVENTS; t++)
+    {
+        local[t].value = trace.total[t];
+        local[t].rank = rank;
+        calls[t] = trace.calls[t];
+    }
+    MPI_Reduce(local, slowest, EVENTS, MPI_DOUBLE_INT, MPI_MAXLOC, TRANSMITTER, MPI_COMM_WORLD);
+    MPI_Reduce(trace.total, fastest, EVENTS, MPI_DOUBLE, MPI_MIN, TRANSMITTER, MPI_COMM_WORLD);
+    MPI_Reduce(trace.total, sum, EVENTS, MPI_DOUBLE, MPI_SUM, TRANSMITTER, MPI_COMM_WORLD);
+    MPI_Reduce(trace.bytes, bytes, EVENTS, MPI_DOUBLE, MPI_SUM, TRANSMITTER, MPI_COMM_WORLD);
+    MPI_Reduce(trace.bytes, max_bytes, EVENTS, MPI_DOUBLE, MPI_MAX, TRANSMITTER, MPI_COMM_WORLD);
+    MPI_Reduce(rank == TRANSMITTER ? MPI_IN_PLACE : calls, calls, EVENTS, MPI_DOUBLE, MPI_SUM, TRANSMITTER, MPI_COMM_WORLD);
+
+    //le résumé est écrit sur la sortie d'erreur pour ne pas se meler au résultat
+    if(rank != TRANSMITTER) return;
+    fprintf(stderr, "%-16s %10s %10s %10s %10s %6s %8s %14s %14s\n", "event", "calls", "min (s)", "avg (s)", "max (s)", "rank", "max/avg", "bytes avg", "bytes max");
+    for(int t = 0; t < EVENTS; t++)
+    {
+        double avg = sum[t] / numprocs;
+        if(calls[t] == 0) continue;
+        fprintf(stderr, "%-16s %10.0f %10.4f %10.4f %10.4f %6d %8.2f %14.0f %14.0f\n",
+                names[t], calls[t] / numprocs, fastest[t], avg, slowest[t].value, slowest[t].rank, avg > 0 ? slowest[t].value / avg : 1, bytes[t] / numprocs, max_bytes[t]);
+    }
+}
+
+
+
+
+//-----------------------------------------------------------------
+//---------------------------CHECKPOINTS---------------------------
+//-----------------------------------------------------------------
+//Avec -C les lignes de chaque machine sont écrites toutes les K itérations de la boucle dans un fichier binaire
+//dont l'entete garde le nombre d'itérations calculées. L'écriture se fait dans <fichier>.part pendant l'itération
+//suivante et n'est renommée qu'une fois terminée sur toutes les machines : le fichier est toujours un checkpoint complet.
+Checkpoint create_checkpoint(Options *options, Matrix *a)
+{
+    Checkpoint cp;
+    int rank, numprocs;
+
+    cp.path = options != NULL ? options->checkpoint : NULL;
+    cp.part = NULL;
+    cp.every = options != NULL ? options->every : 1;
+    cp.engine = options != NULL ? options->engine : 0;
+    cp.checksum = 0;
+    cp.pending = false;
+    cp.buffer = NULL;
+    cp.bytes = 0;
+    if(cp.path == NULL) return cp;
+
+    //le graphe de départ identifie le calcul, a n'est encore que le graphe lu
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
+    cp.checksum = checksum(a, FIRST(rank, numprocs, a->width), MPI_COMM_WORLD);
+
+    //le tampon garde les lignes pendant que le calcul continue sur a
+    cp.part = (char *) malloc(strlen(cp.path) + 6);
+    sprintf(cp.part, "%s.part", cp.path);
+    cp.buffer = (long *) malloc((size(a) > 0 ? size(a) : 1)*sizeof(long));
+    return cp;
+}
+
+
+int resume(Checkpoint *cp, Matrix *a, Matrix *b, int engine, int N, int rank, int numprocs)
+{
+    Header header;
+    Matrix *m;
+
+    //sans checkpoint le calcul commence au début
+    if(cp->path == NULL || read_header(cp->path, &header) || header.reserved <= 0) return 0;
+
+    //les itérations de l'anneau et du carré ne se comptent pas pareil, et un autre graphe donnerait un résultat faux :
+    //un checkpoint d'un autre moteur ou d'un autre graphe est ignoré
+    if(header.size != N || header.engine != engine || header.checksum != cp->checksum)
+    {
+        if(rank == TRANSMITTER) fprintf(stderr, "Checkpoint %s does not match this graph and engine, starting from the beginning\n", cp->path);
+        return 0;
+    }
+
+    //les lignes de la machine sont lues en parallele comme une entrée binaire
+    m = load_block(cp->path, &header, FIRST(rank, numprocs, N), 0, a->height, N, true, MPI_COMM_WORLD);
+    memcpy(a->array, m->array, size(a)*sizeof(long));
+    free(m->array);
+    free(m);
+
+    //l'anneau multiplie toujours par les colonnes du graphe, le carré par celles de la matrice en cours
+    if(engine == ENGINE_SQUARE)
+    {
+        m = load_block(cp->path, &header, 0, FIRST(rank, numprocs, N), N, b->width, false, MPI_COMM_WORLD);
+        memcpy(b->array, m->array, size(b)*sizeof(long));
+        free(m->array);
+        free(m);
+    }
+    if(rank == TRANSMITTER) fprintf(stderr, "Resuming %s at iteration %ld\n", cp->path, (long) header.reserved);
+    return header.reserved;
+}
+
+
+uint64_t checksum(Matrix *a, long first, MPI_Comm comm)
+{
+    uint64_t sum = 0;
+    long n = a->width;
+
+    //chaque valeur est mélangée avec sa position puis sommée : le résultat ne dépend ni de l'ordre ni du découpage des lignes
+    #pragma omp parallel for schedule(static) reduction(+:sum)
+    for(int r = 0; r < a->height; r++)
+    {
+        for(long c = 0; c < n; c++)
+        {
+            uint64_t state = (uint64_t) a->array[r*n + c] ^ ((uint64_t) (first + r)*n + c) * 0x9E3779B97F4A7C15ULL;
+            sum += next_random(&state);
+        }
+    }
+    MPI_Allreduce(MPI_IN_PLACE, &sum, 1, MPI_UINT64_T, MPI_SUM, comm);
+    return sum;
+}
+
+
+bool checkpoint_due(Checkpoint *cp, int iteration, int last)
+{
+    //le résultat final n'a pas besoin de checkpoint
+    return cp->path != NULL && iteration < last && iteration % cp->every == 0;
+}
+
+
+void start_checkpoint(Checkpoint *cp, long *rows, int h, int N, int iteration, int rank, int numprocs)
+{
+    double start;
+    long count = (long) h*N;
+    MPI_Datatype row;
+
+    //le tampon n'est réutilisé qu'une fois l'écriture précédente terminée
+    finish_checkpoint(cp, rank);
+    start = trace_start();
+
+    //la copie se fait sur le chemin du calcul : elle est partagée entre les threads et les valeurs sont gardées telles quelles,
+    //l'entete donne INF comme infini du fichier au lieu de réécrire chaque valeur
+    if(rows != cp->buffer)
+    {
+        #pragma omp parallel for schedule(static)
+        for(long i = 0; i < count; i++) cp->buffer[i] = rows[i];
+    }
+
+    //meme entete que write_rows, l'itération dans reserved suivie du moteur et du graphe qui la rendent valable
+    MPI_File_open(MPI_COMM_WORLD, cp->part, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &cp->file);
+    if(rank == TRANSMITTER)
+    {
+        Header header;
+        memcpy(header.magic, MAGIC, 4);
+        header.width = sizeof(long);
+        header.size = N;
+        header.infinity = INF;
+        header.reserved = iteration;
+        header.engine = cp->engine;
+        header.checksum = cp->checksum;
+        MPI_File_write_at(cp->file, 0, &header, sizeof(Header), MPI_BYTE, MPI_STATUS_IGNORE);
+    }
+
+    //chaque machine lance l'écriture de ses lignes, elle avance pendant les échanges de l'anneau
+    //le compte est en lignes pour rester un int meme quand les lignes d'une machine dépassent 2^31 valeurs
+    MPI_Type_contiguous(N, MPI_LONG, &row);
+    MPI_Type_commit(&row);
+    MPI_File_iwrite_at(cp->file, sizeof(Header) + FIRST(rank, numprocs, N)*(MPI_Offset) N*sizeof(long), cp->buffer, h, row, &cp->request);
+    MPI_Type_free(&row);
+    cp->pending = true;
+    cp->bytes = count*sizeof(long) + (rank == TRANSMITTER ? sizeof(Header) : 0);
+    trace_stop(EVENT_CHECKPOINT, start, 0);
+}
+
+
+void finish_checkpoint(Checkpoint *cp, int rank)
+{
+    double start;
+
+    if(!cp->pending) return;
+    start = trace_start();
+    MPI_Wait(&cp->request, MPI_STATUS_IGNORE);
+    MPI_File_close(&cp->file);
+
+    //toutes les machines ont terminé avant que le fichier remplace le checkpoint précédent
+    MPI_Barrier(MPI_COMM_WORLD);
+    if(rank == TRANSMITTER && rename(cp->part, cp->path) != 0) fprintf(stderr, "Checkpoint %s failed\n", cp->path);
+    cp->pending = false;
+    trace_stop(EVENT_CHECKPOINT, start, cp->bytes);
+}
+
+
+void free_checkpoint(Checkpoint *cp, int rank)
+{
+    finish_checkpoint(cp, rank);
+    free(cp->part);
+    free(cp->buffer);
+}
+
+
+
+
+//-----------------------------------------------------------------
+//-------------------FLOYD-WARSHALL PAR BLOCS----------------------
+//-----------------------------------------------------------------
+Grid create_grid(MPI_Comm comm)
+{
+    Grid grid;
+    int dims[2] = {0, 0}, periods[2] = {0, 0}, coords[2], numprocs;
+    int row_dims[2] = {0, 1}, column_dims[2] = {1, 0};
+
+    //organise les machines en une grille la plus carrée possible sans les renuméroter
+    MPI_Comm_size(comm, &numprocs);
+    MPI_Dims_create(numprocs, 2, dims);
+    MPI_Cart_create(comm, 2, dims, periods, 0, &grid.comm);
+    MPI_Cart_get(grid.comm, 2, dims, periods, coords);
+    grid.rows = dims[0];
+    grid.columns = dims[1];
+    grid.row = coords[0];
+    grid.column = coords[1];
+
+    //dans row_comm le rang est la colonne, dans column_comm le rang est la ligne
+    MPI_Cart_sub(grid.comm, row_dims, &grid.row_comm);
+    MPI_Cart_sub(grid.comm, column_dims, &grid.column_comm);
+    return grid;
+}
+
+
+Matrix *scatter_grid(Matrix *data, int N, Grid *grid, int transmitter)
+{
+    int rank, numprocs, coords[2];
+    int h = N / grid->rows, w = N / grid->columns;
+    MPI_Status status;
+    Matrix *tile = generate_matrix((long *) malloc(h*w*sizeof(long)), h, w, true);
+    double start = trace_start();
+
+    MPI_Comm_rank(grid->comm, &rank);
+    MPI_Comm_size(grid->comm, &numprocs);
+
+    //l'emmetteur découpe la matrice en tuiles et envoie chacune à la machine correspondante
+    //les tuiles du bord dépassent data si N a été ajusté, elles sont complétées par des infinis
+    //les autres machines recoivent directement leur tuile
+    if(rank == transmitter)
+    {
+        for(int p = 0; p < numprocs; p++)
+        {
+            if(p == transmitter) continue;
+            MPI_Cart_coords(grid->comm, p, 2, coords);
+            fill_tile(data, tile, coords[0]*h, coords[1]*w);
+            MPI_Send(tile->array, h*w, MPI_LONG, p, GRID, grid->comm);
+        }
+        fill_tile(data, tile, grid->row*h, grid->column*w);
+    }
+    else MPI_Recv(tile->array, h*w, MPI_LONG, transmitter, GRID, grid->comm, &status);
+    if(rank != transmitter) counters.bytes += h*w*sizeof(long);
+    trace_stop(EVENT_DISTRIBUTE, start, rank != transmitter ? h*w*sizeof(long) : 0);
+    return tile;
+}
+
+
+Matrix *gather_grid(Matrix *tile, int N, Grid *grid, int transmitter)
+{
+    int rank, numprocs, coords[2], M = tile->height*grid->rows;
+    MPI_Status status;
+    Matrix *result = NULL, *full;
+    double start = trace_start();
+
+    MPI_Comm_rank(grid->comm, &rank);
+    MPI_Comm_size(grid->comm, &numprocs);
+
+    //l'emmetteur recoit chaque tuile et la replace dans la matrice de la grille
+    if(rank == transmitter)
+    {
+        result = generate_matrix((long *) malloc((long) M*M*sizeof(long)), M, M, true);
+        replace(result, tile, grid->row*tile->height, grid->column*tile->width);
+        for(int p = 0; p < numprocs; p++)
+        {
+            if(p == transmitter) continue;
+            MPI_Cart_coords(grid->comm, p, 2, coords);
+            MPI_Recv(tile->array, size(tile), MPI_LONG, p, GRID, grid->comm, &status);
+            counters.bytes += size(tile) * sizeof(long);
+            replace(result, tile, coords[0]*tile->height, coords[1]*tile->width);
+        }
+    }
+    else MPI_Send(tile->array, size(tile), MPI_LONG, transmitter, GRID, grid->comm);
+    trace_stop(EVENT_DISTRIBUTE, start, rank == transmitter ? (double) (numprocs - 1) * size(tile) * sizeof(long) : 0);
+
+    //les lignes et colonnes ajoutées pour avoir des tuiles égales sont retirées
+    if(rank == transmitter && M != N)
+    {
+        full = result;
+        result = generate_matrix((long *) malloc((long) N*N*sizeof(long)), N, N, true);
+        extract(full, result, 0, 0);
+        free(full->array);
+        free(full);
+    }
+    return result;
+}
+
+
+void fill_tile(Matrix *data, Matrix *tile, int row, int column)
+{
+    //comme extract, les cases qui ne sont pas dans data n'ont pas d'arc
+    int h = data->height - row < tile->height ? data->height - row : tile->height;
+    int w = data->width - column < tile->width ? data->width - column : tile->width;
+    #pragma omp parallel for schedule(static) proc_bind(close)
+    for(int r = 0; r < tile->height; r++)
+    {
+        for(int c = r < h ? (w > 0 ? w : 0) : 0; c < tile->width; c++) set(tile, r, c, INF);
+    }
+    if(h > 0 && w > 0) copy_block(data, row, column, tile, 0, 0, h, w);
+}
+
+
+void floyd(Matrix *tile, int N, Grid *grid)
+{
+    int h = tile->height, w = tile->width;
+    //les bandes k ont au plus FLOYD_BLOCK sommets et s'arretent au bord des tuiles :
+    //chacune est contenue dans une seule ligne et une seule colonne de la grille, le bloc diagonal reste petit
+    //et presque tout le calcul passe par le noyau min-plus de floyd_update
+    int kb = FLOYD_BLOCK < h ? FLOYD_BLOCK : h, b;
+    kb = kb < w ? kb : w;
+    Arena arena = create_arena((long) kb*kb + 2*(long) kb*w + (long) h*kb);
+    Matrix *d = generate_matrix(arena_alloc(&arena, (long) kb*kb), kb, kb, true);
+    Matrix *r = generate_matrix(arena_alloc(&arena, (long) kb*w), kb, w, true);
+    Matrix *rt = generate_matrix(arena_alloc(&arena, (long) kb*w), kb, w, false);
+    Matrix *c = generate_matrix(arena_alloc(&arena, (long) h*kb), h, kb, true);
+    double start, received;
+
+    for(int k = 0; k < N; k += b)
+    {
+        //ligne et colonne de la grille qui possèdent la bande k, sa position dans leurs tuiles et sa largeur
+        int pr = k / h, pc = k / w;
+        int lr = k - pr*h, lc = k - pc*w;
+        bool in_row = grid->row == pr, in_column = grid->column == pc;
+        b = kb < h - lr ? kb : h - lr;
+        b = b < w - lc ? b : w - lc;
+        d->height = d->width = r->height = rt->height = c->width = b;
+
+        //le propriétaire du bloc diagonal le résout puis le diffuse sur sa ligne et sa colonne
+        start = trace_start();
+        if(in_row && in_column)
+        {
+            extract(tile, d, lr, lc);
+            floyd_diagonal(d);
+            replace(tile, d, lr, lc);
+            counters.operations += (double) b*b*b;
+        }
+        trace_stop(EVENT_FLOYD_COMPUTE, start, 0);
+        start = trace_start();
+        if(in_row) MPI_Bcast(d->array, b*b, MPI_LONG, pc, grid->row_comm);
+        if(in_column) MPI_Bcast(d->array, b*b, MPI_LONG, pr, grid->column_comm);
+        received = in_row != in_column ? b*b*sizeof(long) : 0;
+        counters.bytes += received;
+        trace_stop(EVENT_FLOYD_BROADCAST, start, received);
+
+        //les machines de la ligne et de la colonne du bloc mettent à jour leur bande
+        start = trace_start();
+        if(in_row)
+        {
+            extract(tile, r, lr, 0);
+            floyd_row_panel(d, r);
+            replace(tile, r, lr, 0);
+            counters.operations += (double) b*b*w;
+        }
+        if(in_column)
+        {
+            extract(tile, c, 0, lc);
+            floyd_column_panel(c, d);
+            replace(tile, c, 0, lc);
+            counters.operations += (double) h*b*b;
+        }
+
+        trace_stop(EVENT_FLOYD_COMPUTE, start, 0);
+
+        //chaque machine recoit la bande de lignes de sa colonne et la bande de colonnes de sa ligne
+        start = trace_start();
+        MPI_Bcast(r->array, b*w, MPI_LONG, pr, grid->column_comm);
+        MPI_Bcast(c->array, h*b, MPI_LONG, pc, grid->row_comm);
+        received = (in_row ? 0 : b*w*sizeof(long)) + (in_column ? 0 : h*b*sizeof(long));
+        counters.bytes += received;
+        trace_stop(EVENT_FLOYD_BROADCAST, start, received);
+
+        //toutes les tuiles sont mises à jour avec les deux bandes, le noyau lit la bande de lignes en colonnes
+        start = trace_start();
+        extract(r, rt, 0, 0);
+        floyd_update(tile, c, rt);
+        counters.operations += (double) h*w*b;
+        trace_stop(EVENT_FLOYD_COMPUTE, start, 0);
+    }
+
+    free_arena(&arena);
+    free(d);
+    free(r);
+    free(rt);
+    free(c);
+}
+
+
+Matrix *gather_row_tiles(Matrix *tile, int N, Grid *grid)
+{
+    int h = tile->height, w = tile->width;
+    Matrix *stripe = NULL, *buffer = NULL;
+
+    //les tuiles recues sont rangées les unes à la suite des autres puis replacées dans la bande de lignes
+    if(grid->column == 0)
+    {
+        stripe = generate_matrix((long *) malloc(h*N*sizeof(long)), h, N, true);
+        buffer = generate_matrix((long *) malloc(h*N*sizeof(long)), h, w, true);
+    }
+    MPI_Gather(tile->array, size(tile), MPI_LONG, grid->column == 0 ? buffer->array : NULL, size(tile), MPI_LONG, 0, grid->row_comm);
+    if(grid->column == 0)
+    {
+        long *base = buffer->array;
+        for(int c = 0; c < grid->columns; c++)
+        {
+            buffer->array = base + c*h*w;
+            replace(stripe, buffer, 0, c*w);
+        }
+        free(base);
+        free(buffer);
+    }
+    return stripe;
+}
+
+
+void floyd_diagonal(Matrix *d)
+{
+    //Floyd-Warshall classique, la boucle sur k ne peut pas etre parallélisée
+    //une case sans chemin peut passer sous INF pendant les étapes, elle est ignorée au dela de INF/2 et ramenée à INF à la fin
+    //les blocs sont optimisés en ligne, les lignes i et k sont lues directement dans le tableau
+    int n = d->height;
+    for(int k = 0; k < n; k++)
+    {
+        long *dk = d->array + (long) k*n;
+        #pragma omp parallel for
+        for(int i = 0; i < n; i++)
+        {
+            //une ligne sans chemin vers k ne peut pas etre améliorée
+            long *di = d->array + (long) i*n, dik = di[k];
+            if(dik >= INF / 2) continue;
+            for(int j = 0; j < n; j++)
+            {
+                long s = dik + dk[j];
+                di[j] = s < di[j] ? s : di[j];
+            }
+        }
+    }
+    clamp(d->array, (long) n*n);
+}
+
+
+void floyd_row_panel(Matrix *d, Matrix *r)
+{
+    //r[i][j] = min(r[i][j], d[i][k] + r[k][j]) avec le bloc diagonal déjà résolu
+    int n = r->height, m = r->width;
+    for(int k = 0; k < n; k++)
+    {
+        long *rk = r->array + (long) k*m;
+        #pragma omp parallel for
+        for(int i = 0; i < n; i++)
+        {
+            long *ri = r->array + (long) i*m, dik = d->array[(long) i*n + k];
+            if(dik >= INF / 2) continue;
+            for(int j = 0; j < m; j++)
+            {
+                long s = dik + rk[j];
+                ri[j] = s < ri[j] ? s : ri[j];
+            }
+        }
+    }
+    clamp(r->array, (long) n*m);
+}
+
+
+void floyd_column_panel(Matrix *c, Matrix *d)
+{
+    //c[i][j] = min(c[i][j], c[i][k] + d[k][j]) avec le bloc diagonal déjà résolu
+    int n = c->height, m = c->width;
+    for(int k = 0; k < m; k++)
+    {
+        long *dk = d->array + (long) k*m;
+        #pragma omp parallel for
+        for(int i = 0; i < n; i++)
+        {
+            long *ci = c->array + (long) i*m, cik = ci[k];
+            if(cik >= INF / 2) continue;
+            for(int j = 0; j < m; j++)
+            {
+                long s = cik + dk[j];
+                ci[j] = s < ci[j] ? s : ci[j];
+            }
+        }
+    }
+    clamp(c->array, (long) n*m);
+}
+
+
+void floyd_update(Matrix *t, Matrix *c, Matrix *r)
+{
+    //t[i][j] = min(t[i][j], c[i][k] + r[k][j]), r doit etre optimisée en colonne pour le noyau min-plus
+    minplus(c->array, r->array, t->array, t->height, c->width, t->width, t->width);
+}
+
+
+void floyd_shared(Matrix *m, int element)
+{
+    //memes étapes que floyd sur une grille d'une seule machine, sans message :
+    //seules les bandes sont copiées, dans des tampons alloués une fois, la matrice est mise à jour sur place par le noyau min-plus
+    int n = m->height, kb = n < FLOYD_BLOCK ? n : FLOYD_BLOCK;
+    Arena arena;
+    Matrix *d, *r, *rt, *c;
+    double start;
+
+    //comme solve, les distances sont converties dans un type plus petit si le plus long chemin possible le permet
+    switch(select_element(m, n, element, MPI_COMM_SELF))
+    {
+        case ELEMENT_UINT16: floyd_shared_uint16(m); return;
+        case ELEMENT_INT32: floyd_shared_int32(m); return;
+    }
+    arena = create_arena((long) kb*kb + 3*(long) kb*n);
+    d = generate_matrix(arena_alloc(&arena, (long) kb*kb), kb, kb, true);
+    r = generate_matrix(arena_alloc(&arena, (long) kb*n), kb, n, true);
+    rt = generate_matrix(arena_alloc(&arena, (long) kb*n), kb, n, false);
+    c = generate_matrix(arena_alloc(&arena, (long) n*kb), n, kb, true);
+
+    for(int k = 0; k < n; k += kb)
+    {
+        //la derniere bande peut etre plus étroite
+        int b = n - k < kb ? n - k : kb;
+        d->height = d->width = r->height = rt->height = c->width = b;
+        start = trace_start();
+
+        //bloc diagonal puis bande de lignes et bande de colonnes, chacune recopiée dans la matrice
+        extract(m, d, k, k);
+        floyd_diagonal(d);
+        replace(m, d, k, k);
+        extract(m, r, k, 0);
+        floyd_row_panel(d, r);
+        replace(m, r, k, 0);
+        extract(m, c, 0, k);
+        floyd_column_panel(c, d);
+        replace(m, c, 0, k);
+
+        //toute la matrice est mise à jour avec les deux bandes, le noyau lit la bande de lignes en colonnes
+        extract(r, rt, 0, 0);
+        minplus(c->array, rt->array, m->array, n, b, n, n);
+        counters.operations += (double) b*b*b + 2.0*b*b*n + (double) n*n*b;
+        trace_stop(EVENT_FLOYD_COMPUTE, start, 0);
+    }
+
+    free_arena(&arena);
+    free(d);
+    free(r);
+    free(rt);
+    free(c);
+}
+
+
+
+
+//-----------------------------------------------------------------
+//-------------------PRODUIT SUMMA SUR LA GRILLE-------------------
+//-----------------------------------------------------------------
+//Sur la meme grille que Floyd-Warshall, le produit de tuiles est la somme min-plus des produits de bandes :
+//la bande k de colonnes de a est diffusée sur chaque ligne de la grille, la bande k de lignes de b sur chaque colonne.
+//Chaque machine recoit M*(h+w) valeurs par produit, soit O(N²/√P) au lieu des O(N²) de l'anneau.
+Matrix *summa_process(Matrix *a, Matrix *b, Matrix *c, Grid *grid)
+{
+    int h = c->height, w = c->width, M = h*grid->rows;
+    //chaque bande k est contenue dans une seule colonne de tuiles de a et une seule ligne de tuiles de b
+    int kb = gcd(h, w);
+    Arena arena = create_arena(2*((long) h*kb + (long) kb*w));
+    Matrix *column[2], *row[2];
+    MPI_Request requests[2][2];
+    double start, received;
+
+    //deux jeux de bandes : la bande suivante est diffusée pendant le produit de la bande en cours
+    //la bande de lignes est rangée en colonnes par son propriétaire, comme le noyau la lit
+    for(int i = 0; i < 2; i++)
+    {
+        column[i] = generate_matrix(arena_alloc(&arena, (long) h*kb), h, kb, true);
+        row[i] = generate_matrix(arena_alloc(&arena, (long) kb*w), kb, w, false);
+    }
+    summa_panels(a, b, column[0], row[0], 0, grid, requests[0]);
+    for(int k = 0, cur = 0; k < M; k += kb, cur = 1 - cur)
+    {
+        start = trace_start();
+        MPI_Waitall(2, requests[cur], MPI_STATUSES_IGNORE);
+        received = (grid->column != k / w ? (double) h*kb*sizeof(long) : 0) + (grid->row != k / h ? (double) kb*w*sizeof(long) : 0);
+        counters.bytes += received;
+        trace_stop(EVENT_SUMMA_WAIT, start, received);
+        if(k + kb < M) summa_panels(a, b, column[1 - cur], row[1 - cur], k + kb, grid, requests[1 - cur]);
+
+        //la premiere bande écrit la tuile résultat, les suivantes y prennent le minimum
+        start = trace_start();
+        if(k == 0) minplus_store(column[cur]->array, row[cur]->array, c->array, h, kb, w, w);
+        else minplus(column[cur]->array, row[cur]->array, c->array, h, kb, w, w);
+        counters.operations += (double) h*w*kb;
+        trace_stop(EVENT_SUMMA_COMPUTE, start, 0);
+    }
+
+    free_arena(&arena);
+    for(int i = 0; i < 2; i++)
+    {
+        free(column[i]);
+        free(row[i]);
+    }
+    return c;
+}
+
+
+void summa_panels(Matrix *a, Matrix *b, Matrix *column, Matrix *row, int k, Grid *grid, MPI_Request *requests)
+{
+    //colonne de la grille qui possède la bande de a, ligne de la grille qui possède celle de b
+    int pc = k / a->width, pr = k / b->height;
+
+    if(grid->column == pc) extract(a, column, 0, k - pc*a->width);
+    if(grid->row == pr) extract(b, row, k - pr*b->height, 0);
+
+    //dans row_comm le rang est la colonne, dans column_comm le rang est la ligne
+    MPI_Ibcast(column->array, size(column), MPI_LONG, pc, grid->row_comm, &requests[0]);
+    MPI_Ibcast(row->array, size(row), MPI_LONG, pr, grid->column_comm, &requests[1]);
+}
+
+
+void summa(Matrix *tile, int N, Grid *grid)
+{
+    Matrix *c = generate_matrix((long *) malloc(size(tile)*sizeof(long)), tile->height, tile->width, true);
+    long *tmp;
+    int changed = 1, steps = 1;
+
+    //comme square : 2^steps couvre les chemins de N-1 arcs, on s'arrete dès que la matrice ne change plus
+    //la diagonale est nulle, le carré ne peut donc que diminuer les distances
+    while((1 << steps) < N - 1) steps++;
+    for(int k = 0; k < steps && changed; k++)
+    {
+        summa_process(tile, tile, c, grid);
+        changed = !equals(tile, c);
+        MPI_Allreduce(MPI_IN_PLACE, &changed, 1, MPI_INT, MPI_LOR, grid->comm);
+
+        //le résultat devient la tuile, l'ancienne tuile le tampon du prochain produit
+        tmp = tile->array;
+        tile->array = c->array;
+        c->array = tmp;
+    }
+    free(c->array);
+    free(c);
+}
+
+
+
+
+//-----------------------------------------------------------------
+//-------------------------GRAPHES CREUX---------------------------
+//-----------------------------------------------------------------
+//Quand presque toutes les cases sont infinies, un Dijkstra depuis chaque source ne parcourt que les arcs
+//au lieu des N^3 additions du produit min-plus. Les sources sont les lignes de chaque machine,
+//le résultat a donc la meme répartition que celui des autres moteurs.
+Graph *load_graph(char *path)
+{
+    FILE *file;
+    Graph *g;
+    long val, k = 0, capacity = 256;
+    int ch, n = 0;
+    bool token = false;
+
+    file = fopen(path, "r");
+    if(file == NULL) return NULL;
+
+    //la premiere ligne donne le nombre de sommets
+    while((ch = fgetc(file)) != EOF && ch != '\n')
+    {
+        if(ch != ' ' && ch != '\t' && ch != '\r' && !token) n++;
+        token = ch != ' ' && ch != '\t' && ch != '\r';
+    }
+    rewind(file);
+
+    g = (Graph *) malloc(sizeof(Graph));
+    g->n = n;
+    g->edges = 0;
+    g->negative = false;
+    g->offsets = (long *) calloc(n + 1, sizeof(long));
+    g->targets = (int *) malloc(capacity*sizeof(int));
+    g->weights = (long *) malloc(capacity*sizeof(long));
+
+    //comme dans load_matrix un 0 hors de la diagonale ou une valeur trop grande est l'absence d'arc, les valeurs sont lues ligne par ligne
+    while(k < (long) n*n && fscanf(file, " %ld", &val) == 1)
+    {
+        int row = k / n, column = k % n;
+        k++;
+        if(val != 0 && val < INF && row != column)
+        {
+            if(g->edges == capacity)
+            {
+                capacity *= 2;
+                g->targets = (int *) realloc(g->targets, capacity*sizeof(int));
+                g->weights = (long *) realloc(g->weights, capacity*sizeof(long));
+            }
+            g->targets[g->edges] = column;
+            g->weights[g->edges++] = val;
+            g->negative = g->negative || val < 0;
+        }
+        g->offsets[row + 1] = g->edges;
+    }
+    fclose(file);
+
+    //les lignes manquantes d'un fichier tronqué n'ont pas d'arc
+    for(int v = 0; v < n; v++) if(g->offsets[v + 1] < g->offsets[v]) g->offsets[v + 1] = g->offsets[v];
+    return g;
+}
+
+
+Graph *read_graph(char *path, Header *header, bool binary, int rank, int numprocs)
+{
+    Graph *g;
+    Matrix *a;
+    int N = header->size;
+
+    //un fichier binaire est lu en bandes de lignes par toutes les machines puis assemblé partout
+    if(binary)
+    {
+        a = load_block(path, header, FIRST(rank, numprocs, N), 0, PART(rank, numprocs, N), N, true, MPI_COMM_WORLD);
+        g = graph_from_rows(a, MPI_COMM_WORLD);
+        free(a->array);
+        free(a);
+        return g;
+    }
+
+    //sinon l'emmeteur lit le texte, les autres machines ne recoivent que la taille pour choisir le moteur
+    if(rank == TRANSMITTER) g = load_graph(path);
+    else
+    {
+        g = (Graph *) calloc(1, sizeof(Graph));
+    }
+    MPI_Bcast(&g->n, 1, MPI_INT, TRANSMITTER, MPI_COMM_WORLD);
+    MPI_Bcast(&g->edges, 1, MPI_LONG, TRANSMITTER, MPI_COMM_WORLD);
+    MPI_Bcast(&g->negative, sizeof(bool), MPI_BYTE, TRANSMITTER, MPI_COMM_WORLD);
+    return g;
+}
+
+
+Graph *graph_from_rows(Matrix *a, MPI_Comm comm)
+{
+    Graph *g = (Graph *) malloc(sizeof(Graph));
+    int h = a->height, n = a->width, first_row, rank, numprocs, local = 0, *counts, *displs;
+    long *degrees = (long *) malloc(n*sizeof(long)), *own;
+    int *targets;
+    long *weights;
+
+    MPI_Comm_size(comm, &numprocs);
+    MPI_Comm_rank(comm, &rank);
+    first_row = FIRST(rank, numprocs, n);
+    own = degrees + first_row;
+    counts = (int *) malloc(numprocs*sizeof(int));
+    displs = (int *) malloc(numprocs*sizeof(int));
+
+    //arcs des lignes de la machine, la diagonale est ignorée
+    for(int r = 0; r < h; r++)
+    {
+        for(int c = 0; c < n; c++) local += a->array[(long) r*n + c] < INF && first_row + r != c;
+    }
+    targets = (int *) malloc((local + 1)*sizeof(int));
+    weights = (long *) malloc((local + 1)*sizeof(long));
+    local = 0;
+    for(int r = 0; r < h; r++)
+    {
+        own[r] = 0;
+        for(int c = 0; c < n; c++)
+        {
+            if(a->array[(long) r*n + c] >= INF || first_row + r == c) continue;
+            targets[local] = c;
+            weights[local++] = a->array[(long) r*n + c];
+            own[r]++;
+        }
+    }
+
+    //chaque machine recoit les degrés de toutes les lignes puis les arcs dans l'ordre des machines
+    partition(n, numprocs, 1, counts, displs);
+    MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, degrees, counts, displs, MPI_LONG, comm);
+    MPI_Allgather(&local, 1, MPI_INT, counts, 1, MPI_INT, comm);
+    displs[0] = 0;
+    for(int p = 1; p < numprocs; p++) displs[p] = displs[p-1] + counts[p-1];
+
+    g->n = n;
+    g->offsets = (long *) malloc((n + 1)*sizeof(long));
+    g->offsets[0] = 0;
+    for(int v = 0; v < n; v++) g->offsets[v+1] = g->offsets[v] + degrees[v];
+    g->edges = g->offsets[n];
+    g->targets = (int *) malloc((g->edges + 1)*sizeof(int));
+    g->weights = (long *) malloc((g->edges + 1)*sizeof(long));
+    MPI_Allgatherv(targets, local, MPI_INT, g->targets, counts, displs, MPI_INT, comm);
+    MPI_Allgatherv(weights, local, MPI_LONG, g->weights, counts, displs, MPI_LONG, comm);
+    counters.bytes += (double) (n - h) * sizeof(long) + (double) (g->edges - local) * (sizeof(int) + sizeof(long));
+
+    g->negative = false;
+    for(long e = 0; e < g->edges; e++) g->negative = g->negative || g->weights[e] < 0;
+
+    free(degrees);
+    free(counts);
+    free(displs);
+    free(targets);
+    free(weights);
+    return g;
+}
+
+
+void broadcast_graph(Graph *g, int transmitter, int rank)
+{
+    //la taille et le nombre d'arcs sont déjà connus de toutes les machines
+    if(rank != transmitter)
+    {
+        g->offsets = (long *) malloc((g->n + 1)*sizeof(long));
+        g->targets = (int *) malloc((g->edges + 1)*sizeof(int));
+        g->weights = (long *) malloc((g->edges + 1)*sizeof(long));
+    }
+    MPI_Bcast(g->offsets, g->n + 1, MPI_LONG, transmitter, MPI_COMM_WORLD);
+    MPI_Bcast(g->targets, g->edges, MPI_INT, transmitter, MPI_COMM_WORLD);
+    MPI_Bcast(g->weights, g->edges, MPI_LONG, transmitter, MPI_COMM_WORLD);
+}
+
+
+Matrix *graph_matrix(Graph *g)
+{
+    int N = g->n;
+    Matrix *m = generate_matrix((long *) malloc((long) N*N*sizeof(long)), N, N, true);
+
+    //meme matrice que load_matrix : diagonale nulle et infini sans arc
+    #pragma omp parallel for schedule(static) proc_bind(close)
+    for(int r = 0; r < N; r++)
+    {
+        for(int c = 0; c < N; c++) m->array[(long) r*N + c] = r == c ? 0 : INF;
+        for(long e = g->offsets[r]; e < g->offsets[r+1]; e++) m->array[(long) r*N + g->targets[e]] = g->weights[e];
+    }
+    return m;
+}
+
+
+int select_engine(Graph *g, Options *options)
+{
+    double density = g->n > 1 ? (double) g->edges / ((double) g->n * (g->n - 1)) : 1;
+    int numprocs;
+
+    //Dijkstra demande des poids positifs, les prédécesseurs, les mises à jour et les checkpoints ne sont gérés que par les moteurs en anneau
+    if(g->negative || options->paths || options->updates != NULL || options->service || options->checkpoint != NULL || options->restart) return ENGINE_SQUARE;
+    if(options->engine == ENGINE_SPARSE || density < SPARSE_DENSITY) return ENGINE_SPARSE;
+
+    //une seule machine n'a rien à échanger, Floyd-Warshall sur place y est le plus rapide
+    MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
+    return numprocs == 1 ? ENGINE_SHARED : ENGINE_SQUARE;
+}
+
+
+Matrix *sparse(Graph *g, int rank, int numprocs)
+{
+    int N = g->n, h = PART(rank, numprocs, N), first = FIRST(rank, numprocs, N);
+    Matrix *a = generate_matrix((long *) malloc((long) h*N*sizeof(long)), h, N, true);
+    double start = trace_start();
+
+    //chaque thread a son tas, les sources sont distribuées dynamiquement car leur cout varie
+    #pragma omp parallel
+    {
+        Node *heap = (Node *) malloc((g->edges + 1)*sizeof(Node));
+        #pragma omp for schedule(dynamic)
+        for(int r = 0; r < h; r++)
+        {
+            long *dist = a->array + (long) r*N;
+            for(int c = 0; c < N; c++) dist[c] = INF;
+            dijkstra(g, first + r, dist, heap);
+        }
+        free(heap);
+    }
+
+    //chaque Dijkstra relache au plus une fois chaque arc
+    counters.operations += (double) h * g->edges;
+    trace_stop(EVENT_DIJKSTRA, start, 0);
+    return a;
+}
+
+
+void dijkstra(Graph *g, int source, long *dist, Node *heap)
+{
+    int size = 0, child, parent;
+    Node node, last;
+
+    //tas binaire sans mise à jour de priorité : un sommet peut y etre plusieurs fois,
+    //les copies dont la distance est dépassée sont ignorées à la sortie
+    dist[source] = 0;
+    heap[size++] = (Node) {0, source};
+    while(size > 0)
+    {
+        node = heap[0];
+        last = heap[--size];
+        for(parent = 0; (child = 2*parent + 1) < size; parent = child)
+        {
+            if(child + 1 < size && heap[child + 1].dist < heap[child].dist) child++;
+            if(heap[child].dist >= last.dist) break;
+            heap[parent] = heap[child];
+        }
+        heap[parent] = last;
+
+        if(node.dist > dist[node.vertex]) continue;
+        for(long e = g->offsets[node.vertex]; e < g->offsets[node.vertex + 1]; e++)
+        {
+            long d = node.dist + g->weights[e];
+            int v = g->targets[e];
+            if(d >= dist[v]) continue;
+            dist[v] = d;
+            for(child = size++; child > 0 && heap[(child - 1) / 2].dist > d; child = (child - 1) / 2) heap[child] = heap[(child - 1) / 2];
+            heap[child] = (Node) {d, v};
+        }
+    }
+}
+
+
+void free_graph(Graph *g)
+{
+    free(g->offsets);
+    free(g->targets);
+    free(g->weights);
+    free(g);
+}
+
+
+
+
+//-----------------------------------------------------------------
+//--------------------ACCESSIBILITE EN BITS------------------------
+//-----------------------------------------------------------------
+//Avec -a seule l'existence d'un chemin compte : la ligne i devient N bits, le bit j vaut 1 si l'arc i -> j existe ou si i = j.
+//Le produit booléen ajoute la ligne k de b à la ligne i de c quand a[i][k] vaut 1, soit un OU de N/64 mots par bit à 1
+//au lieu de N additions et minimums. La répartition et l'anneau transportent 64 fois moins de données que les distances.
+uint64_t *pack_bits(Matrix *m)
+{
+    int words = WORDS(m->width);
+    uint64_t *bits = (uint64_t *) calloc((long) m->height*words + 1, sizeof(uint64_t));
+
+    //m est optimisée en ligne, chaque ligne est compressée par un seul thread
+    #pragma omp parallel for schedule(static)
+    for(int r = 0; r < m->height; r++)
+    {
+        long *row = m->array + (long) r*m->width;
+        for(int j = 0; j < m->width; j++) if(row[j] < INF) bits[(long) r*words + j/64] |= (uint64_t) 1 << (j % 64);
+    }
+    return bits;
+}
+
+
+Matrix *unpack_bits(uint64_t *bits, int h, int N)
+{
+    int words = WORDS(N);
+    Matrix *m = generate_matrix((long *) malloc(((long) h*N + 1)*sizeof(long)), h, N, true);
+
+    #pragma omp parallel for schedule(static)
+    for(int r = 0; r < h; r++)
+    {
+        for(int j = 0; j < N; j++) m->array[(long) r*N + j] = (bits[(long) r*words + j/64] >> (j % 64)) & 1;
+    }
+    return m;
+}
+
+
+uint64_t *scatter_bits(Matrix *data, int N, int transmitter, int rank, int numprocs)
+{
+    int words = WORDS(N), part = PART(rank, numprocs, N);
+    int *counts = (int *) malloc(numprocs*sizeof(int)), *displs = (int *) malloc(numprocs*sizeof(int));
+    uint64_t *all = rank == transmitter ? pack_bits(data) : NULL;
+    uint64_t *rows = (uint64_t *) malloc(((long) part*words + 1)*sizeof(uint64_t));
+    double start = trace_start(), received = rank != transmitter ? (double) part * words * sizeof(uint64_t) : 0;
+
+    //les lignes compressées sont contigues comme celles de data, découpées comme dans scatter_collective
+    counters.bytes += received;
+    partition(N, numprocs, words, counts, displs);
+    MPI_Scatterv(all, counts, displs, MPI_UINT64_T, rows, part*words, MPI_UINT64_T, transmitter, MPI_COMM_WORLD);
+    trace_stop(EVENT_DISTRIBUTE, start, received);
+    free(all);
+    free(counts);
+    free(displs);
+    return rows;
+}
+
+
+Matrix *gather_bits(uint64_t *rows, int N, int transmitter, int rank, int numprocs)
+{
+    Matrix *result = NULL;
+    int words = WORDS(N), part = PART(rank, numprocs, N);
+    int *counts = (int *) malloc(numprocs*sizeof(int)), *displs = (int *) malloc(numprocs*sizeof(int));
+    uint64_t *all = rank == transmitter ? (uint64_t *) malloc((long) N*words*sizeof(uint64_t)) : NULL;
+    double start = trace_start(), received = rank == transmitter ? (double) (N - part) * words * sizeof(uint64_t) : 0;
+
+    //les lignes restent compressées pendant l'échange, seul l'emmeteur les décompresse
+    counters.bytes += received;
+    partition(N, numprocs, words, counts, displs);
+    MPI_Gatherv(rows, part*words, MPI_UINT64_T, all, counts, displs, MPI_UINT64_T, transmitter, MPI_COMM_WORLD);
+    trace_stop(EVENT_DISTRIBUTE, start, received);
+    if(rank == transmitter) result = unpack_bits(all, N, N);
+    free(all);
+    free(counts);
+    free(displs);
+    return result;
+}
+
+
+uint64_t *closure(uint64_t *a, int N, int rank, int numprocs)
+{
+    int changed = 1, steps = 1, h = PART(rank, numprocs, N), words = WORDS(N);
+    long length = (long) MAX_PART(numprocs, N)*words + 1;
+    uint64_t *b, *c, *spare, *tmp;
+
+    //une seule machine : Warshall directement sur les lignes, sans message
+    if(numprocs == 1)
+    {
+        warshall(a, N);
+        return a;
+    }
+
+    //carrés successifs comme square, la diagonale à 1 rend chaque carré croissant
+    //le produit booléen lit les lignes de b : b est une copie des lignes a, sans redistribute
+    b = (uint64_t *) malloc(length*sizeof(uint64_t));
+    spare = (uint64_t *) malloc(length*sizeof(uint64_t));
+    c = (uint64_t *) malloc(length*sizeof(uint64_t));
+    while((1 << steps) < N - 1) steps++;
+    for(int k = 0; k < steps && changed; k++)
+    {
+        memcpy(b, a, (long) h*words*sizeof(uint64_t));
+        process_bits(a, &b, c, &spare, N, rank, numprocs);
+        changed = memcmp(a, c, (long) h*words*sizeof(uint64_t)) != 0;
+        MPI_Allreduce(MPI_IN_PLACE, &changed, 1, MPI_INT, MPI_LOR, MPI_COMM_WORLD);
+        tmp = a;
+        a = c;
+        c = tmp;
+    }
+    free(b);
+    free(spare);
+    free(c);
+    return a;
+}
+
+
+void process_bits(uint64_t *a, uint64_t **b, uint64_t *c, uint64_t **spare, int N, int rank, int numprocs)
+{
+    //meme anneau que process_##NAME, le bloc qui tourne est formé des lignes de la machine d'origine
+    MPI_Request requests[2];
+    int done, h = PART(rank, numprocs, N), words = WORDS(N);
+    double start, received;
+    uint64_t *tmp;
+
+    memset(c, 0, (long) h*words*sizeof(uint64_t));
+    for(int i = 0; i < numprocs; i++)
+    {
+        int owner = CURRENT(rank-i,numprocs), source = CURRENT(rank-i-1,numprocs);
+        int first = FIRST(owner, numprocs, N), w = PART(owner, numprocs, N);
+        start = trace_start();
+        MPI_Irecv(*spare, words*PART(source, numprocs, N), MPI_UINT64_T, PREVIOUS(rank, numprocs), PROCESS, MPI_COMM_WORLD, &requests[0]);
+        MPI_Isend(*b, words*w, MPI_UINT64_T, NEXT(rank, numprocs), PROCESS, MPI_COMM_WORLD, &requests[1]);
+        #pragma omp parallel proc_bind(close)
+        {
+            int t = omp_get_thread_num(), threads = omp_get_num_threads(), last = FIRST(t + 1, threads, h);
+            for(int r = FIRST(t, threads, h); r < last && w > 0; r++)
+            {
+                or_rows(a + (long) r*words, *b, first, w, c + (long) r*words, words);
+                if(t == 0 && r % PROGRESS_ROWS == 0) MPI_Testall(2, requests, &done, MPI_STATUSES_IGNORE);
+            }
+        }
+        trace_stop(EVENT_RING_COMPUTE, start, 0);
+        start = trace_start();
+        MPI_Waitall(2, requests, MPI_STATUSES_IGNORE);
+        received = numprocs > 1 ? (double) words * PART(source, numprocs, N) * sizeof(uint64_t) : 0;
+        counters.operations += (double) h * w * words;
+        counters.bytes += received;
+        trace_stop(EVENT_RING_WAIT, start, received);
+        tmp = *b;
+        *b = *spare;
+        *spare = tmp;
+    }
+}
+
+
+CLONES void or_rows(uint64_t *a, uint64_t *b, int first, int w, uint64_t *c, int words)
+{
+    //seuls les bits first à first+w-1 de a sont lus, chaque mot est copié avant que c, qui peut etre a, ne change
+    int low = first / 64, high = (first + w - 1) / 64;
+    for(int q = low; q <= high; q++)
+    {
+        uint64_t word = a[q];
+        if(q == low) word &= ~(uint64_t) 0 << (first % 64);
+        if(q == high && (first + w) % 64 != 0) word &= ~(uint64_t) 0 >> (64 - (first + w) % 64);
+        while(word != 0)
+        {
+            uint64_t *bk = b + (long) (q*64 + __builtin_ctzll(word) - first)*words;
+            for(int j = 0; j < words; j++) c[j] |= bk[j];
+            word &= word - 1;
+        }
+    }
+}
+
+
+void warshall(uint64_t *rows, int N)
+{
+    //la ligne k ne change pas pendant l'étape k, les autres lignes sont réparties entre les threads
+    int words = WORDS(N);
+    for(int k = 0; k < N; k++)
+    {
+        #pragma omp parallel for schedule(static) proc_bind(close)
+        for(int i = 0; i < N; i++)
+        {
+            if(i != k) or_rows(rows + (long) i*words, rows + (long) k*words, k, 1, rows + (long) i*words, words);
+        }
+    }
+    counters.operations += (double) N * N * words;
+}
+
+
+
+
+//-----------------------------------------------------------------
+//--------------------MANIPULATION DE MATRICE----------------------
+//-----------------------------------------------------------------
+Matrix *matrix_process(Matrix *m1, Matrix *m2)
+{
+    //genere une matrice avec pour hauteur m1 et pour largeur m2
+    Matrix *res = generate_matrix((long *) malloc(m1->height*m2->width*sizeof(long)), m1->height, m2->width, true);
+    int n=m1->height, p=m1->width, m=m2->width;
+
+    //le noyau parcourt m1 en ligne et m2 en colonne, on copie les matrices qui ne respectent pas cette optimisation
+    Matrix *x = m1->row_opti ? m1 : copy_matrix(m1, true);
+    Matrix *y = m2->row_opti ? copy_matrix(m2, false) : m2;
+
+    //remplace dans la multiplication classique de matrice l'opération de multiplication par une addition et l'opération de somme par le minimum 
+    minplus_store(x->array, y->array, res->array, n, p, m, m);
+
+    if(x != m1) { free(x->array); free(x); }
+    if(y != m2) { free(y->array); free(y); }
+    return res;
+}
+
+
+Matrix *matrix_process_path(Matrix *m1, Matrix *m2, Matrix *p1, Matrix *p2, int column, Matrix **pred)
+{
+    //p1 a les dimensions du produit : prédécesseurs de m1 dans les colonnes couvertes par m2
+    //p2 a les dimensions de m2 : prédécesseurs de ses colonnes
+    int n=m1->height, p=m1->width, m=m2->width;
+    Matrix *res = generate_matrix((long *) malloc(n*m*sizeof(long)), n, m, true);
+    *pred = generate_matrix((long *) malloc(n*m*sizeof(long)), n, m, true);
+
+    //comme matrix_process, on copie les matrices qui ne respectent pas l'optimisation du noyau
+    Matrix *x = m1->row_opti ? m1 : copy_matrix(m1, true);
+    Matrix *y = m2->row_opti ? copy_matrix(m2, false) : m2;
+    Matrix *px = p1->row_opti ? p1 : copy_matrix(p1, true);
+    Matrix *py = p2->row_opti ? copy_matrix(p2, false) : p2;
+
+    minplus_path(x->array, y->array, px->array, py->array, res->array, (*pred)->array, n, p, m, m, column);
+
+    if(x != m1) { free(x->array); free(x); }
+    if(y != m2) { free(y->array); free(y); }
+    if(px != p1) { free(px->array); free(px); }
+    if(py != p2) { free(py->array); free(py); }
+    return res;
+}
+
+
+
+
+
+//-----------------------------------------------------------------
+//-------------------------NOYAU MIN-PLUS--------------------------
+//-----------------------------------------------------------------
+//Les valeurs sont au plus INF : a + b ne déborde jamais, le produit est un simple minimum de sommes
+//sans branchement que le compilateur peut vectoriser. Seul le résultat de chaque case est ramené à INF par CLAMP
+Kernel select_kernel(char *name)
+{
+    //un noyau peut etre imposé, sinon on prend le plus large supporté par le processeur
+    if(name != NULL && strcmp(name, "scalar") == 0) return minplus_scalar;
+#ifdef X86_KERNELS
+    __builtin_cpu_init();
+    if(name != NULL && strcmp(name, "avx2") == 0 && __builtin_cpu_supports("avx2")) return minplus_avx2;
+    if(name != NULL && strcmp(name, "avx512") == 0 && __builtin_cpu_supports("avx512f")) return minplus_avx512;
+    if(name == NULL && __builtin_cpu_supports("avx512f")) return minplus_avx512;
+    if(name == NULL && __builtin_cpu_supports("avx2")) return minplus_avx2;
+#endif
+    return minplus_scalar;
+}
+
+
+void minplus_store(long *a, long *b, long *c, int n, int p, int m, int ldc)
+{
+    //le noyau accumule dans c, le bloc résultat est donc d'abord mis à l'infini
+    for(int r = 0; r < n; r++)
+    {
+        for(int j = 0; j < m; j++) c[(long) r*ldc + j] = INF;
+    }
+    minplus(a, b, c, n, p, m, ldc);
+}
+
+
+void minplus_tiles(long *a, long *b, long *c, int n, int p, int m, int ldc, Micro micro)
+{
+    //chaque tuile associe TILE_ROWS lignes de a à 4 colonnes de b
+    //le produit est découpé en passes de TILE_DEPTH pour que les 4 colonnes restent dans le cache L1
+    #pragma omp parallel for collapse(2) schedule(static) proc_bind(close)
+    for(int rr = 0; rr < n; rr += TILE_ROWS)
+    {
+        for(int jj = 0; jj < m; jj += 4)
+        {
+            int rlimit = rr + TILE_ROWS < n ? rr + TILE_ROWS : n;
+            for(int ii = 0; ii < p; ii += TILE_DEPTH)
+            {
+                int len = ii + TILE_DEPTH < p ? TILE_DEPTH : p - ii;
+                for(int r = rr; r < rlimit; r++)
+                {
+                    if(jj + 4 <= m) micro(a + (long) r*p + ii, b + (long) jj*p + ii, p, len, c + (long) r*ldc + jj);
+                    else for(int j = jj; j < m; j++) minplus_micro(a + (long) r*p + ii, b + (long) j*p + ii, len, c + (long) r*ldc + j);
+                }
+            }
+        }
+    }
+}
+
+
+void minplus_micro(long *a, long *b, int len, long *c)
+{
+    //termine aussi chaque passe des micro noyaux vectorisés : CLAMP n'est appliqué qu'une fois par case et par passe
+    long min = *c;
+    for(int i = 0; i < len; i++)
+    {
+        long s = a[i] + b[i];
+        min = min < s ? min : s;
+    }
+    *c = CLAMP(min);
+}
+
+
+void minplus_path(long *a, long *b, long *pa, long *pb, long *c, long *pc, int n, int p, int m, int ldc, int column)
+{
+    //meme découpage que minplus_tiles, une colonne de b à la fois
+    //pc retient d'abord l'indice i du minimum de a[r][i] + b[i][j], puis le prédécesseur de la case :
+    //  celui de b[i][j] qui termine le chemin, ou celui de a[r][j] si le minimum est atteint sur la diagonale de b
+    //  une case ramenée à INF n'a pas de prédécesseur
+    #pragma omp parallel for collapse(2) schedule(static) proc_bind(close)
+    for(int rr = 0; rr < n; rr += TILE_ROWS)
+    {
+        for(int j = 0; j < m; j++)
+        {
+            int rlimit = rr + TILE_ROWS < n ? rr + TILE_ROWS : n;
+            for(int r = rr; r < rlimit; r++)
+            {
+                c[(long) r*ldc + j] = INF;
+                pc[(long) r*ldc + j] = -1;
+            }
+            for(int ii = 0; ii < p; ii += TILE_DEPTH)
+            {
+                int len = ii + TILE_DEPTH < p ? TILE_DEPTH : p - ii;
+                for(int r = rr; r < rlimit; r++) minplus_path_micro(a + (long) r*p + ii, b + (long) j*p + ii, ii, len, c + (long) r*ldc + j, pc + (long) r*ldc + j);
+            }
+            for(int r = rr; r < rlimit; r++)
+            {
+                long i = c[(long) r*ldc + j] >= INF / 2 ? -1 : pc[(long) r*ldc + j];
+                c[(long) r*ldc + j] = CLAMP(c[(long) r*ldc + j]);
+                if(i < 0) pc[(long) r*ldc + j] = -1;
+                else if(i == column + j) pc[(long) r*ldc + j] = pa[(long) r*ldc + j];
+                else pc[(long) r*ldc + j] = pb[(long) j*p + i];
+            }
+        }
+    }
+}
+
+
+CLONES void minplus_path_micro(long *a, long *b, int first, int len, long *c, long *arg)
+{
+    //chaque voie garde son minimum et le premier indice qui l'atteint
+    //à égalité on garde le plus petit indice pour que le résultat ne dépende pas du découpage
+    vector_long acc, idx, cur, s, mask;
+    long best = INF, index = -1;
+    int i;
+
+    for(int l = 0; l < 4; l++)
+    {
+        acc[l] = INF;
+        idx[l] = -1;
+        cur[l] = first + l;
+    }
+    for(i = 0; i + 4 <= len; i += 4)
+    {
+        s = *(unaligned_long *) (a + i) + *(unaligned_long *) (b + i);
+        mask = s < acc;
+        acc = (s & mask) | (acc & ~mask);
+        idx = (cur & mask) | (idx & ~mask);
+        cur += 4;
+    }
+    for(int l = 0; l < 4; l++)
+    {
+        if(idx[l] >= 0 && (acc[l] < best || (acc[l] == best && idx[l] < index)))
+        {
+            best = acc[l];
+            index = idx[l];
+        }
+    }
+    for(; i < len; i++)
+    {
+        long v = a[i] + b[i];
+        if(v < best)
+        {
+            best = v;
+            index = first + i;
+        }
+    }
+
+    //les passes précédentes ont des indices plus petits, elles gardent l'égalité
+    if(best < *c)
+    {
+        *c = best;
+        *arg = index;
+    }
+}
+
+
+void minplus_scalar(long *a, long *b, long *c, int n, int p, int m, int ldc)
+{
+    minplus_tiles(a, b, c, n, p, m, ldc, minplus_scalar4);
+}
+
+
+void minplus_scalar4(long *a, long *b, int ldb, int len, long *c)
+{
+    for(int q = 0; q < 4; q++) minplus_micro(a, b + (long) q*ldb, len, c + q);
+}
+
+
+#ifdef X86_KERNELS
+void minplus_avx2(long *a, long *b, long *c, int n, int p, int m, int ldc)
+{
+    minplus_tiles(a, b, c, n, p, m, ldc, minplus_avx2_4);
+}
+
+
+__attribute__((target("avx2")))
+void minplus_avx2_4(long *a, long *b, int ldb, int len, long *c)
+{
+    //AVX2 n'a pas de minimum sur 64 bits, il est obtenu avec une comparaison et un mélange
+    __m256i acc[4];
+    long tmp[4];
+    int i;
+
+    for(int q = 0; q < 4; q++) acc[q] = _mm256_set1_epi64x(INF);
+    for(i = 0; i + 4 <= len; i += 4)
+    {
+        __m256i va = _mm256_loadu_si256((__m256i *) (a + i));
+        for(int q = 0; q < 4; q++)
+        {
+            __m256i s = _mm256_add_epi64(va, _mm256_loadu_si256((__m256i *) (b + (long) q*ldb + i)));
+            acc[q] = _mm256_blendv_epi8(acc[q], s, _mm256_cmpgt_epi64(acc[q], s));
+        }
+    }
+
+    //réduit chaque accumulateur et termine les éléments restants sans vectorisation
+    for(int q = 0; q < 4; q++)
+    {
+        _mm256_storeu_si256((__m256i *) tmp, acc[q]);
+        for(int t = 0; t < 4; t++) c[q] = c[q] < tmp[t] ? c[q] : tmp[t];
+        minplus_micro(a + i, b + (long) q*ldb + i, len - i, c + q);
+    }
+}
+
+
+void minplus_avx512(long *a, long *b, long *c, int n, int p, int m, int ldc)
+{
+    minplus_tiles(a, b, c, n, p, m, ldc, minplus_avx512_4);
+}
+
+
+__attribute__((target("avx512f")))
+void minplus_avx512_4(long *a, long *b, int ldb, int len, long *c)
+{
+    __m512i acc[4];
+    int i;
+
+    for(int q = 0; q < 4; q++) acc[q] = _mm512_set1_epi64(INF);
+    for(i = 0; i + 8 <= len; i += 8)
+    {
+        __m512i va = _mm512_loadu_si512((void *) (a + i));
+        for(int q = 0; q < 4; q++)
+        {
+            __m512i vb = _mm512_loadu_si512((void *) (b + (long) q*ldb + i));
+            acc[q] = _mm512_min_epi64(acc[q], _mm512_add_epi64(va, vb));
+        }
+    }
+
+    //réduit chaque accumulateur et termine les éléments restants sans vectorisation
+    for(int q = 0; q < 4; q++)
+    {
+        long min = _mm512_reduce_min_epi64(acc[q]);
+        c[q] = c[q] < min ? c[q] : min;
+        minplus_micro(a + i, b + (long) q*ldb + i, len - i, c + q);
+    }
+}
+#endif
+
+
+
+
+//-----------------------------------------------------------------
+//-------------------------TYPES COMPACTS--------------------------
+//-----------------------------------------------------------------
+//Les fonctions de chaque type sont générées par DEFINE_COMPACT, LIMIT est la moitié de la valeur maximale du type
+//et représente l'infini : comme pour les long, la somme de deux valeurs ne déborde jamais
+#define DEFINE_COMPACT(T, NAME, LIMIT, MPI_T)                                                                                                 \
+typedef T vector_##NAME __attribute__((vector_size(32)));                                                                                   \
+typedef T unaligned_##NAME __attribute__((vector_size(32), aligned(1), may_alias));                                                         \
+                                                                                                                                            \
+CLONES void minplus_micro_##NAME(T *a, T *b, int len, T *c)                                                                                 \
+{                                                                                                                                           \
+    /* somme simple sur des vecteurs de 32 octets, les masques remplacent les branchements du minimum */                                    \
+    vector_##NAME acc, s, mask;                                                                                                             \
+    int lanes = sizeof(vector_##NAME) / sizeof(T), i;                                                                                       \
+    T min = *c;                                                                                                                             \
+                                                                                                                                            \
+    for(int l = 0; l < lanes; l++) acc[l] = LIMIT;                                                                                          \
+    for(i = 0; i + lanes <= len; i += lanes)                                                                                                \
+    {                                                                                                                                       \
+        s = *(unaligned_##NAME *) (a + i) + *(unaligned_##NAME *) (b + i);                                                                  \
+        mask = (vector_##NAME) (s < acc);                                                                                                   \
+        acc = (s & mask) | (acc & ~mask);                                                                                                   \
+    }                                                                                                                                       \
+    for(int l = 0; l < lanes; l++) min = acc[l] < min ? acc[l] : min;                                                                       \
+    for(; i < len; i++)                                                                                                                     \
+    {                                                                                                                                       \
+        T v = a[i] + b[i];                                                                                                                  \
+        min = v < min ? v : min;                                                                                                            \
+    }                                                                                                                                       \
+    *c = min;                                                                                                                               \
+}                                                                                                                                           \
+                                                                                                                                            \
+void minplus_##NAME(T *a, T *b, T *c, int n, int p, int m, int ldc)                                                                         \
+{                                                                                                                                           \
+    /* meme découpage en tuiles que minplus_tiles, le produit est ajouté à c comme avec minplus */                                          \
+    _Pragma("omp parallel for collapse(2) schedule(static) proc_bind(close)")                                                               \
+    for(int rr = 0; rr < n; rr += TILE_ROWS)                                                                                                \
+    {                                                                                                                                       \
+        for(int j = 0; j < m; j++)                                                                                                          \
+        {                                                                                                                                   \
+            int rlimit = rr + TILE_ROWS < n ? rr + TILE_ROWS : n;                                                                           \
+            for(int ii = 0; ii < p; ii += TILE_DEPTH)                                                                                       \
+            {                                                                                                                               \
+                int len = ii + TILE_DEPTH < p ? TILE_DEPTH : p - ii;                                                                        \
+                for(int r = rr; r < rlimit; r++) minplus_micro_##NAME(a + (long) r*p + ii, b + (long) j*p + ii, len, c + (long) r*ldc + j); \
+            }                                                                                                                               \
+        }                                                                                                                                   \
+    }                                                                                                                                       \
+}                                                                                                                                           \
+                                                                                                                                            \
+void minplus_store_##NAME(T *a, T *b, T *c, int n, int p, int m, int ldc)                                                                   \
+{                                                                                                                                           \
+    /* comme minplus_store, le bloc résultat est d'abord mis à l'infini */                                                                  \
+    for(int r = 0; r < n; r++)                                                                                                              \
+    {                                                                                                                                       \
+        for(int j = 0; j < m; j++) c[(long) r*ldc + j] = LIMIT;                                                                             \
+    }                                                                                                                                       \
+    minplus_##NAME(a, b, c, n, p, m, ldc);                                                                                                  \
+}                                                                                                                                           \
+                                                                                                                                            \
+void pack_##NAME(long *src, T *dst, long count)                                                                                             \
+{                                                                                                                                           \
+    _Pragma("omp parallel for schedule(static) proc_bind(close)")                                                                           \
+    for(long i = 0; i < count; i++) dst[i] = src[i] >= INF ? LIMIT : (T) src[i];                                                            \
+}                                                                                                                                           \
+                                                                                                                                            \
+void unpack_##NAME(T *src, long *dst, long count)                                                                                           \
+{                                                                                                                                           \
+    _Pragma("omp parallel for schedule(static) proc_bind(close)")                                                                           \
+    for(long i = 0; i < count; i++) dst[i] = src[i] >= LIMIT ? INF : (long) src[i];                                                         \
+}                                                                                                                                           \
+                                                                                                                                            \
+void process_##NAME(T *a, T **b, T *c, T **spare, int N, int rank, int numprocs)                                                            \
+{                                                                                                                                           \
+    /* meme anneau que process, avec des blocs compacts dont la largeur est la part de la machine d'origine */                              \
+    /* chaque place garde la meme part des lignes, comme dans process */                                                                    \
+    MPI_Request requests[2];                                                                                                                \
+    int done, h = PART(rank, numprocs, N), *places = (int *) malloc(omp_get_max_threads()*sizeof(int));                                     \
+    double start, received;                                                                                                                 \
+    T *tmp;                                                                                                                                 \
+                                                                                                                                            \
+    for(int i = 0; i < numprocs; i++)                                                                                                       \
+    {                                                                                                                                       \
+        int owner = CURRENT(rank-i,numprocs), source = CURRENT(rank-i-1,numprocs);                                                          \
+        int column = FIRST(owner, numprocs, N), w = PART(owner, numprocs, N);                                                               \
+        start = trace_start();                                                                                                              \
+        MPI_Irecv(*spare, N*PART(source, numprocs, N), MPI_T, PREVIOUS(rank, numprocs), PROCESS, MPI_COMM_WORLD, &requests[0]);             \
+        MPI_Isend(*b, N*w, MPI_T, NEXT(rank, numprocs), PROCESS, MPI_COMM_WORLD, &requests[1]);                                             \
+        _Pragma("omp parallel proc_bind(close)")                                                                                            \
+        {                                                                                                                                   \
+            int t = omp_get_thread_num(), threads = omp_get_num_threads(), s = thread_slot(places), last = FIRST(s + 1, threads, h);        \
+            for(int r = FIRST(s, threads, h); r < last; r += PROGRESS_ROWS)                                                                 \
+            {                                                                                                                               \
+                int rows = r + PROGRESS_ROWS < last ? PROGRESS_ROWS : last - r;                                                             \
+                minplus_store_##NAME(a + (long) r*N, *b, c + (long) r*N + column, rows, N, w, N);                                           \
+                if(t == 0) MPI_Testall(2, requests, &done, MPI_STATUSES_IGNORE);                                                            \
+            }                                                                                                                               \
+        }                                                                                                                                   \
+        trace_stop(EVENT_RING_COMPUTE, start, 0);                                                                                           \
+        start = trace_start();                                                                                                              \
+        MPI_Waitall(2, requests, MPI_STATUSES_IGNORE);                                                                                      \
+        received = numprocs > 1 ? (double) N * PART(source, numprocs, N) * sizeof(T) : 0;                                                   \
+        counters.operations += (double) h * N * w;                                                                                          \
+        counters.bytes += received;                                                                                                         \
+        trace_stop(EVENT_RING_WAIT, start, received);                                                                                       \
+        tmp = *b;                                                                                                                           \
+        *b = *spare;                                                                                                                        \
+        *spare = tmp;                                                                                                                       \
+    }                                                                                                                                       \
+    free(places);                                                                                                                           \
+}                                                                                                                                           \
+                                                                                                                                            \
+void redistribute_##NAME(T *a, T *b, T *out, T *in, int N, int rank, int numprocs)                                                          \
+{                                                                                                                                           \
+    /* meme échange que redistribute, a est optimisée en ligne et b en colonne */                                                           \
+    int h = PART(rank, numprocs, N);                                                                                                        \
+    double start, received;                                                                                                                 \
+    for(int s = 0; s < numprocs; s++)                                                                                                       \
+    {                                                                                                                                       \
+        int dest = CURRENT(rank+s, numprocs), src = CURRENT(rank-s, numprocs);                                                              \
+        int wd = PART(dest, numprocs, N), hs = PART(src, numprocs, N), cd = FIRST(dest, numprocs, N), rs = FIRST(src, numprocs, N);         \
+        start = trace_start();                                                                                                              \
+        for(int c = 0; c < wd; c++)                                                                                                         \
+        {                                                                                                                                   \
+            for(int r = 0; r < h; r++) out[c*h + r] = a[(long) r*N + cd + c];                                                               \
+        }                                                                                                                                   \
+        MPI_Sendrecv(out, h*wd, MPI_T, dest, REDISTRIBUTE, in, hs*h, MPI_T, src, REDISTRIBUTE, MPI_COMM_WORLD, MPI_STATUS_IGNORE);          \
+        received = src != rank ? (double) hs * h * sizeof(T) : 0;                                                                           \
+        counters.bytes += received;                                                                                                         \
+        trace_stop(EVENT_REDISTRIBUTE, start, received);                                                                                    \
+        for(int c = 0; c < h; c++)                                                                                                          \
+        {                                                                                                                                   \
+            for(int r = 0; r < hs; r++) b[(long) c*N + rs + r] = in[c*hs + r];                                                              \
+        }                                                                                                                                   \
+    }                                                                                                                                       \
+}                                                                                                                                           \
+                                                                                                                                            \
+Matrix *compute_##NAME(Matrix *a, Matrix *b, Workspace *ws, Checkpoint *cp, int first, int N, int engine, int rank, int numprocs)           \
+{                                                                                                                                           \
+    /* les blocs compacts ont leurs propres tampons à la taille du type : a et b y sont compressées, puis l'espace de travail long */       \
+    /* est libéré avant d'allouer les autres, la boucle n'utilise que des tampons compacts et l'espace long est reconstruit à la fin */     \
+    int changed = 1, steps = 1, part = MAX_PART(numprocs, N);                                                                               \
+    long column = (long) N*part;                                                                                                            \
+    T *blocks = (T *) malloc(((long) size(a) + column)*sizeof(T)), *work, *ca = blocks, *cb = blocks + size(a), *cc, *cs, *out, *in, *tmp;  \
+                                                                                                                                            \
+    pack_##NAME(a->array, ca, size(a));                                                                                                     \
+    pack_##NAME(b->array, cb, size(b));                                                                                                     \
+    free_workspace(ws);                                                                                                                     \
+    work = (T *) malloc(((long) size(a) + column + 2L*part*part)*sizeof(T));                                                                \
+    cc = work;                                                                                                                              \
+    cs = cc + size(a);                                                                                                                      \
+    out = cs + column;                                                                                                                      \
+    in = out + (long) part*part;                                                                                                            \
+                                                                                                                                            \
+    /* un checkpoint est écrit en long : les lignes sont décompressées dans son tampon, libre depuis la fin de l'itération précédente */    \
+    if(engine == ENGINE_RING)                                                                                                               \
+    {                                                                                                                                       \
+        for(int i = first; i < N; i++)                                                                                                      \
+        {                                                                                                                                   \
+            process_##NAME(ca, &cb, cc, &cs, N, rank, numprocs);                                                                            \
+            tmp = ca;                                                                                                                       \
+            ca = cc;                                                                                                                        \
+            cc = tmp;                                                                                                                       \
+            finish_checkpoint(cp, rank);                                                                                                    \
+            if(!checkpoint_due(cp, i + 1, N)) continue;                                                                                     \
+            unpack_##NAME(ca, cp->buffer, size(a));                                                                                         \
+            start_checkpoint(cp, cp->buffer, a->height, N, i + 1, rank, numprocs);                                                          \
+        }                                                                                                                                   \
+    }                                                                                                                                       \
+    else                                                                                                                                    \
+    {                                                                                                                                       \
+        while((1 << steps) < N - 1) steps++;                                                                                                \
+        for(int k = first; k < steps && changed; k++)                                                                                       \
+        {                                                                                                                                   \
+            process_##NAME(ca, &cb, cc, &cs, N, rank, numprocs);                                                                            \
+            changed = memcmp(ca, cc, size(a)*sizeof(T)) != 0;                                                                               \
+            MPI_Allreduce(MPI_IN_PLACE, &changed, 1, MPI_INT, MPI_LOR, MPI_COMM_WORLD);                                                     \
+            tmp = ca;                                                                                                                       \
+            ca = cc;                                                                                                                        \
+            cc = tmp;                                                                                                                       \
+            finish_checkpoint(cp, rank);                                                                                                    \
+            if(changed && k + 1 < steps) redistribute_##NAME(ca, cb, out, in, N, rank, numprocs);                                           \
+            if(!changed || !checkpoint_due(cp, k + 1, steps)) continue;                                                                     \
+            unpack_##NAME(ca, cp->buffer, size(a));                                                                                         \
+            start_checkpoint(cp, cp->buffer, a->height, N, k + 1, rank, numprocs);                                                          \
+        }                                                                                                                                   \
+    }                                                                                                                                       \
+                                                                                                                                            \
+    /* comme avec les long, a garde les distances et b les colonnes de la derniere matrice multipliée */                                    \
+    a->array = (long *) malloc(((long) size(a) > 0 ? size(a) : 1)*sizeof(long));                                                            \
+    b->array = (long *) malloc(column*sizeof(long));                                                                                        \
+    unpack_##NAME(ca, a->array, size(a));                                                                                                   \
+    unpack_##NAME(cb, b->array, size(b));                                                                                                   \
+    free(blocks);                                                                                                                           \
+    free(work);                                                                                                                             \
+    *ws = create_workspace(a, b, numprocs);                                                                                                 \
+    return a;                                                                                                                               \
+}                                                                                                                                           \
+                                                                                                                                            \
+void relax_##NAME(T *c, T *a, T *b, int h, int w, int depth, int ld)                                                                        \
+{                                                                                                                                           \
+    /* c[i][j] = min(c[i][j], a[i][k] + b[k][j]) pour k croissant, les blocs peuvent se recouvrir comme dans floyd_diagonal */              \
+    for(int k = 0; k < depth; k++)                                                                                                          \
+    {                                                                                                                                       \
+        _Pragma("omp parallel for schedule(static) proc_bind(close)")                                                                       \
+        for(int i = 0; i < h; i++)                                                                                                          \
+        {                                                                                                                                   \
+            T *ci = c + (long) i*ld, *bk = b + (long) k*ld, aik = a[(long) i*ld + k];                                                       \
+            if(aik >= LIMIT) continue;                                                                                                      \
+            for(int j = 0; j < w; j++)                                                                                                      \
+            {                                                                                                                               \
+                T s = aik + bk[j];                                                                                                          \
+                ci[j] = s < ci[j] ? s : ci[j];                                                                                              \
+            }                                                                                                                               \
+        }                                                                                                                                   \
+    }                                                                                                                                       \
+}                                                                                                                                           \
+                                                                                                                                            \
+void floyd_shared_##NAME(Matrix *m)                                                                                                         \
+{                                                                                                                                           \
+    /* memes étapes que floyd_shared sur la matrice compacte, mise à jour sur place : seules les bandes lues par le noyau sont copiées */   \
+    int n = m->height, kb = n < FLOYD_BLOCK ? n : FLOYD_BLOCK;                                                                              \
+    T *t = (T *) malloc((long) n*n*sizeof(T)), *c = (T *) malloc((long) n*kb*sizeof(T)), *r = (T *) malloc((long) kb*n*sizeof(T));          \
+    double start;                                                                                                                           \
+                                                                                                                                            \
+    pack_##NAME(m->array, t, (long) n*n);                                                                                                   \
+    for(int k = 0; k < n; k += kb)                                                                                                          \
+    {                                                                                                                                       \
+        int b = n - k < kb ? n - k : kb;                                                                                                    \
+        T *d = t + (long) k*n + k;                                                                                                          \
+        start = trace_start();                                                                                                              \
+        relax_##NAME(d, d, d, b, b, b, n);                                                                                                  \
+        relax_##NAME(t + (long) k*n, d, t + (long) k*n, b, n, b, n);                                                                        \
+        relax_##NAME(t + k, t + k, d, n, b, b, n);                                                                                          \
+                                                                                                                                            \
+        /* la bande de colonnes est rangée en lignes de b valeurs, la bande de lignes en colonnes de b valeurs */                           \
+        _Pragma("omp parallel for schedule(static) proc_bind(close)")                                                                       \
+        for(int i = 0; i < n; i++)                                                                                                          \
+        {                                                                                                                                   \
+            memcpy(c + (long) i*b, t + (long) i*n + k, b*sizeof(T));                                                                        \
+            for(int kk = 0; kk < b; kk++) r[(long) i*b + kk] = t[(long) (k + kk)*n + i];                                                    \
+        }                                                                                                                                   \
+        minplus_##NAME(c, r, t, n, b, n, n);                                                                                                \
+        counters.operations += (double) b*b*b + 2.0*b*b*n + (double) n*n*b;                                                                 \
+        trace_stop(EVENT_FLOYD_COMPUTE, start, 0);                                                                                          \
+    }                                                                                                                                       \
+    unpack_##NAME(t, m->array, (long) n*n);                                                                                                 \
+    free(t);                                                                                                                                \
+    free(c);                                                                                                                                \
+    free(r);                                                                                                                                \
+}
+
+DEFINE_COMPACT(int32_t, int32, INT32_MAX / 2, MPI_INT32_T)
+DEFINE_COMPACT(uint16_t, uint16, UINT16_MAX / 2, MPI_UINT16_T)
+
+
+int select_element(Matrix *a, int n, int element, MPI_Comm comm)
+{
+    long bounds[2] = {0, 0};
+    int fit, rank;
+
+    //les valeurs sont toujours représentables en long
+    if(element == ELEMENT_LONG) return element;
+
+    //plus grande valeur finie et opposé de la plus petite valeur sur toutes les machines
+    for(int i = 0; i < size(a); i++)
+    {
+        if(a->array[i] < INF && a->array[i] > bounds[0]) bounds[0] = a->array[i];
+        if(-a->array[i] > bounds[1]) bounds[1] = -a->array[i];
+    }
+    MPI_Allreduce(MPI_IN_PLACE, bounds, 2, MPI_LONG, MPI_MAX, comm);
+
+    //un plus court chemin a au plus n-1 arcs, il doit rester strictement inférieur à l'infini du type
+    if(bounds[1] > 0 || (n > 1 && bounds[0] > (INF - 1) / (n - 1))) fit = ELEMENT_LONG;
+    else if(bounds[0] * (n - 1) < UINT16_MAX / 2) fit = ELEMENT_UINT16;
+    else if(bounds[0] * (n - 1) < INT32_MAX / 2) fit = ELEMENT_INT32;
+    else fit = ELEMENT_LONG;
+    if(element == ELEMENT_AUTO) return fit;
+
+    //un type imposé n'est gardé que si le plus long chemin y tient aussi, sinon les distances déborderaient en silence
+    if(fit == ELEMENT_LONG || (fit == ELEMENT_INT32 && element == ELEMENT_UINT16))
+    {
+        MPI_Comm_rank(comm, &rank);
+        if(rank == TRANSMITTER) fprintf(stderr, "Weights do not fit in %s, computing in long\n", element == ELEMENT_UINT16 ? "uint16" : "int32");
+        return ELEMENT_LONG;
+    }
+    return element;
+}
+
+
+
+
+//-----------------------------------------------------------------
+//------------------------REMPLACEMENTS----------------------------
+//-----------------------------------------------------------------
+void replace(Matrix *a, Matrix *b, int row, int column)
+{
+    //remplace aux coordonnées row colums et aux suivantes les valeurs de a par celles de b 
+    copy_block(b, 0, 0, a, row, column, b->height, b->width);
+}
+
+
+void extract(Matrix *a, Matrix *b, int row, int column)
+{
+    //rempli b avec les valeurs de a à partir des coordonnées row column
+    copy_block(a, row, column, b, 0, 0, b->height, b->width);
+}
+
+
+void copy_block(Matrix *src, int row, int column, Matrix *dst, int drow, int dcolumn, int h, int w)
+{
+    //chaque matrice est parcourue dans son sens : par lignes si elle est optimisée en ligne, sinon par colonnes
+    //s[i*lds+j] est la case j de la ligne (ou colonne) i du bloc dans src, d[i*ldd+j] de meme dans dst
+    long lds = src->row_opti ? src->width : src->height, ldd = dst->row_opti ? dst->width : dst->height;
+    long *s = src->array + (src->row_opti ? row*lds + column : column*lds + row);
+    long *d = dst->array + (dst->row_opti ? drow*ldd + dcolumn : dcolumn*ldd + drow);
+    int outer = src->row_opti ? h : w, inner = src->row_opti ? w : h;
+
+    //meme optimisation : les lignes (ou colonnes) du bloc sont contigues dans les deux matrices
+    if(src->row_opti == dst->row_opti)
+    {
+        #pragma omp parallel for schedule(static) proc_bind(close)
+        for(int i = 0; i < outer; i++) memcpy(d + i*ldd, s + i*lds, inner*sizeof(long));
+        return;
+    }
+
+    //sinon le bloc est transposé par tuiles carrées : les lignes lues et les colonnes écrites d'une tuile restent dans le cache
+    #pragma omp parallel for collapse(2) schedule(static) proc_bind(close)
+    for(int ii = 0; ii < outer; ii += COPY_TILE)
+    {
+        for(int jj = 0; jj < inner; jj += COPY_TILE)
+        {
+            int ilimit = ii + COPY_TILE < outer ? ii + COPY_TILE : outer, jlimit = jj + COPY_TILE < inner ? jj + COPY_TILE : inner;
+            for(int i = ii; i < ilimit; i++)
+            {
+                for(int j = jj; j < jlimit; j++) d[j*ldd + i] = s[i*lds + j];
+            }
+        }
+    }
+}
+
+
+bool equals(Matrix *a, Matrix *b)
+{
+    //les deux matrices doivent avoir la meme taille et la meme optimisation
+    if(a->height != b->height || a->width != b->width || a->row_opti != b->row_opti) return false;
+    return memcmp(a->array, b->array, size(a)*sizeof(long)) == 0;
+}
+
+
+void clamp(long *values, long count)
+{
+    //appliqué une fois à la fin d'un calcul en place, voir CLAMP
+    #pragma omp parallel for schedule(static)
+    for(long i = 0; i < count; i++) values[i] = CLAMP(values[i]);
+}
+
+
+
+
+//-----------------------------------------------------------------
+//----------------------------UTILS--------------------------------
+//-----------------------------------------------------------------
+void set(Matrix *matrix, int row, int column, long value)
+{
+    //change la valeur aux coordonnées row column
+    //la position dans la memoire est determinée en foction de l'optimisation
+    if(matrix->row_opti) matrix->array[row*matrix->width+column]=value;
+    else matrix->array[column*matrix->height+row]=value;
+}
+
+long get(Matrix *matrix, int row, int column)
+{
+    //retourne la valeur aux coordonnées row column
+    //la position dans la memoire est determinée en foction de l'optimisation
+    if(matrix->row_opti) return matrix->array[row*matrix->width+column];
+    else return matrix->array[column*matrix->height+row];
+}
+
+int size(Matrix *matrix)
+{
+    //retourne le nombre de données dans la matrice
+    return matrix->width*matrix->height;
+}
+
+int gcd(int a, int b)
+{
+    //algorithme d'Euclide
+    while(b != 0)
+    {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+void display_matrix(Matrix *m)
+{
+    //affiche la matrice ligne par ligne avec chaque valeur séparées par une espace
+    for(int r = 0; r < m->height; r++)
+    {
+        for(int c = 0; c < m->width; c++)
+        {
+            if(get(m,r,c) >= INF) printf("%c ", 'i');
+            else printf("%ld ", get(m,r,c));
+        }
+        printf("\n");
+    }
+}
+
+int parse_options(int argc, char *argv[], Options *options)
+{
+    //valeurs par défaut
+    options->path = NULL;
+    options->engine = ENGINE_AUTO;
+    options->distribution = DISTRIBUTION_COLLECTIVE;
+    options->element = ELEMENT_AUTO;
+    options->kernel = NULL;
+    options->convert = NULL;
+    options->output = NULL;
+    options->binary_output = false;
+    options->queries = NULL;
+    options->nb_queries = 0;
+    options->updates = NULL;
+    options->paths = false;
+    options->service = false;
+    options->hybrid = false;
+    options->generator = GENERATOR_NONE;
+    options->sizes = NULL;
+    options->nb_sizes = 0;
+    options->threads = NULL;
+    options->nb_threads = 0;
+    options->seed = 1;
+    options->density = 1.0 / 31;
+    options->trace = NULL;
+    options->checkpoint = NULL;
+    options->every = 1;
+    options->restart = false;
+    options->manifest = NULL;
+    options->reachability = false;
+
+    //lit les options, le dernier argument restant est le fichier de données
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-e") == 0 && i + 1 < argc)
+        {
+            i++;
+            if(strcmp(argv[i], "ring") == 0) options->engine = ENGINE_RING;
+            else if(strcmp(argv[i], "square") == 0) options->engine = ENGINE_SQUARE;
+            else if(strcmp(argv[i], "floyd") == 0) options->engine = ENGINE_FLOYD;
+            else if(strcmp(argv[i], "summa") == 0) options->engine = ENGINE_SUMMA;
+            else if(strcmp(argv[i], "shared") == 0) options->engine = ENGINE_SHARED;
+            else if(strcmp(argv[i], "none") == 0) options->engine = ENGINE_NONE;
+            else if(strcmp(argv[i], "sparse") == 0) options->engine = ENGINE_SPARSE;
+            else if(strcmp(argv[i], "auto") == 0) options->engine = ENGINE_AUTO;
+            else return 1;
+        }
+        else if(strcmp(argv[i], "-d") == 0 && i + 1 < argc)
+        {
+            i++;
+            if(strcmp(argv[i], "ring") == 0) options->distribution = DISTRIBUTION_RING;
+            else if(strcmp(argv[i], "collective") == 0) options->distribution = DISTRIBUTION_COLLECTIVE;
+            else return 1;
+        }
+        else if(strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+        {
+            i++;
+            if(strcmp(argv[i], "auto") == 0) options->element = ELEMENT_AUTO;
+            else if(strcmp(argv[i], "long") == 0) options->element = ELEMENT_LONG;
+            else if(strcmp(argv[i], "int32") == 0) options->element = ELEMENT_INT32;
+            else if(strcmp(argv[i], "uint16") == 0) options->element = ELEMENT_UINT16;
+            else return 1;
+        }
+        else if(strcmp(argv[i], "-k") == 0 && i + 1 < argc) options->kernel = argv[++i];
+        else if(strcmp(argv[i], "-c") == 0 && i + 1 < argc) options->convert = argv[++i];
+        else if(strcmp(argv[i], "-o") == 0 && i + 1 < argc) options->output = argv[++i];
+        else if(strcmp(argv[i], "-b") == 0) options->binary_output = true;
+        else if(strcmp(argv[i], "-u") == 0 && i + 1 < argc) options->updates = argv[++i];
+        else if(strcmp(argv[i], "-p") == 0) options->paths = true;
+        else if(strcmp(argv[i], "-s") == 0) options->service = true;
+        else if(strcmp(argv[i], "-H") == 0) options->hybrid = true;
+        else if(strcmp(argv[i], "-T") == 0 && i + 1 < argc) options->trace = argv[++i];
+        else if(strcmp(argv[i], "-C") == 0 && i + 1 < argc) options->checkpoint = argv[++i];
+        else if(strcmp(argv[i], "-K") == 0 && i + 1 < argc)
+        {
+            if((options->every = atoi(argv[++i])) <= 0) return 1;
+        }
+        else if(strcmp(argv[i], "-R") == 0) options->restart = true;
+        else if(strcmp(argv[i], "-M") == 0 && i + 1 < argc) options->manifest = argv[++i];
+        else if(strcmp(argv[i], "-a") == 0) options->reachability = true;
+        else if(strcmp(argv[i], "-B") == 0 && i + 1 < argc)
+        {
+            i++;
+            if(strcmp(argv[i], "dense") == 0) options->generator = GENERATOR_DENSE;
+            else if(strcmp(argv[i], "er") == 0) options->generator = GENERATOR_ER;
+            else if(strcmp(argv[i], "grid") == 0) options->generator = GENERATOR_GRID;
+            else return 1;
+        }
+        else if(strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+        {
+            if((options->sizes = parse_list(argv[++i], &options->nb_sizes)) == NULL) return 1;
+        }
+        else if(strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+        {
+            if((options->threads = parse_list(argv[++i], &options->nb_threads)) == NULL) return 1;
+        }
+        else if(strcmp(argv[i], "-S") == 0 && i + 1 < argc) options->seed = atol(argv[++i]);
+        else if(strcmp(argv[i], "-D") == 0 && i + 1 < argc) options->density = atof(argv[++i]);
+        else if(strcmp(argv[i], "-q") == 0 && i + 2 < argc)
+        {
+            options->queries = (int *) realloc(options->queries, 2*(options->nb_queries + 1)*sizeof(int));
+            options->queries[2*options->nb_queries] = atoi(argv[++i]);
+            options->queries[2*options->nb_queries + 1] = atoi(argv[++i]);
+            options->nb_queries++;
+            options->paths = true;
+        }
+        else if(options->path == NULL) options->path = argv[i];
+        else return 1;
+    }
+
+    //le mode benchmark génere ses graphes, 256 sommets si aucune taille n'est donnée
+    if(options->generator != GENERATOR_NONE && options->sizes == NULL) options->sizes = parse_list("256", &options->nb_sizes);
+
+    //sans calcul les prédécesseurs ne peuvent pas etre déduits des distances
+    //les checkpoints ne gardent que les distances, une reprise perdrait les prédécesseurs
+    //l'accessibilité n'a ni distances ni prédécesseurs à garder en mémoire ou à mettre à jour
+    return (options->path == NULL && options->generator == GENERATOR_NONE && options->manifest == NULL) || (options->engine == ENGINE_NONE && options->paths)
+        || (options->checkpoint != NULL && options->paths) || (options->restart && options->checkpoint == NULL)
+        || (options->reachability && (options->paths || options->updates != NULL || options->service || options->checkpoint != NULL));
+}
+
+int *parse_list(char *text, int *count)
+{
+    int *list = NULL;
+    char *end;
+    long value;
+
+    *count = 0;
+    while(*text != '\0')
+    {
+        value = strtol(text, &end, 10);
+        if(end == text || value <= 0 || value > INT_MAX || (*end != ',' && *end != '\0'))
+        {
+            free(list);
+            return NULL;
+        }
+        list = (int *) realloc(list, (*count + 1)*sizeof(int));
+        list[(*count)++] = value;
+        text = *end == ',' ? end + 1 : end;
+    }
+    return list;
+}
+
+int path(long *pred, int N, int i, int j, int *nodes)
+{
+    int count = 0, k = j;
+
+    //on remonte les prédécesseurs depuis j jusqu'à i, seule la ligne i est nécessaire
+    //un chemin a au plus N sommets
+    if(i == j)
+    {
+        nodes[0] = i;
+        return 1;
+    }
+    while(k != i)
+    {
+        if(k < 0 || count >= N) return 0;
+        nodes[count++] = k;
+        k = pred[k];
+    }
+    nodes[count++] = i;
+
+    //les sommets ont été trouvés à l'envers
+    for(int s = 0; s < count / 2; s++)
+    {
+        k = nodes[s];
+        nodes[s] = nodes[count - 1 - s];
+        nodes[count - 1 - s] = k;
+    }
+    return count;
+}
+
+void display_path(long *pred, int N, int i, int j)
+{
+    int *nodes = (int *) malloc(N*sizeof(int));
+    int count = 0;
+
+    if(pred != NULL && j >= 0 && j < N) count = path(pred, N, i, j, nodes);
+    printf("path %d %d :", i, j);
+    if(count == 0) printf(" none");
+    for(int s = 0; s < count; s++) printf(s == 0 ? " %d" : " -> %d", nodes[s]);
+    printf("\n");
+    free(nodes);
+}
+
+int format_value(long value, char *out)
+{
+    //écrit les chiffres à l'envers dans un tampon puis les recopie, l'infini s'écrit i
+    char digits[24];
+    int len = 0, n = 0;
+    unsigned long v = value < 0 ? -(unsigned long) value : (unsigned long) value;
+
+    if(value >= INF)
+    {
+        out[0] = 'i';
+        return 1;
+    }
+    do
+    {
+        digits[n++] = '0' + v % 10;
+        v /= 10;
+    } while(v != 0);
+    if(value < 0) out[len++] = '-';
+    while(n > 0) out[len++] = digits[--n];
+    return len;
+}
+
+int write_rows(char *path, Matrix *rows, int first_row, int n, bool binary, MPI_Comm comm)
+{
+    MPI_File file;
+    int rank, height = 0;
+    long long len = 0, offset = 0, rounds, done = 0;
+    char *buffer;
+
+    MPI_Comm_rank(comm, &rank);
+
+    //seules les lignes et colonnes qui ne sont pas des ajouts sont écrites
+    if(rows != NULL) height = first_row + rows->height < n ? rows->height : (n - first_row > 0 ? n - first_row : 0);
+    buffer = (char *) malloc((size_t) height*n*(binary ? sizeof(long) : 21) + height + 1);
+
+    //en binaire les lignes ont une taille fixe et sont placées après l'entete, l'infini y est écrit LONG_MAX
+    //en texte chaque machine formate ses lignes comme display_matrix et sa position est la somme des longueurs précédentes
+    if(binary)
+    {
+        for(int r = 0; r < height; r++)
+        {
+            long *out = (long *) (buffer + r*(long) n*sizeof(long)), *in = rows->array + r*(long) rows->width;
+            for(int c = 0; c < n; c++) out[c] = in[c] >= INF ? LONG_MAX : in[c];
+        }
+        len = height*(long long) n*sizeof(long);
+        offset = sizeof(Header) + first_row*(long long) n*sizeof(long);
+    }
+    else
+    {
+        for(int r = 0; r < height; r++)
+        {
+            for(int c = 0; c < n; c++)
+            {
+                len += format_value(get(rows, r, c), buffer + len);
+                buffer[len++] = ' ';
+            }
+            buffer[len++] = '\n';
+        }
+        MPI_Exscan(&len, &offset, 1, MPI_LONG_LONG, MPI_SUM, comm);
+        if(rank == 0) offset = 0;
+    }
+
+    //toutes les machines écrivent en meme temps leur partie du fichier
+    if(MPI_File_open(comm, path, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS)
+    {
+        free(buffer);
+        return 1;
+    }
+    MPI_File_set_size(file, 0);
+    if(binary && rank == 0)
+    {
+        Header header;
+        memcpy(header.magic, MAGIC, 4);
+        header.width = sizeof(long);
+        header.size = n;
+        header.infinity = LONG_MAX;
+        header.reserved = 0;
+        header.engine = 0;
+        header.checksum = 0;
+        MPI_File_write_at(file, 0, &header, sizeof(Header), MPI_BYTE, MPI_STATUS_IGNORE);
+    }
+
+    //une machine peut avoir plus de 2 Go à écrire : elle écrit par morceaux de IO_CHUNK octets,
+    //toutes font le meme nombre d'écritures collectives et celles qui ont fini écrivent 0 octet
+    rounds = (len + IO_CHUNK - 1) / IO_CHUNK;
+    MPI_Allreduce(MPI_IN_PLACE, &rounds, 1, MPI_LONG_LONG, MPI_MAX, comm);
+    for(long long k = 0; k < rounds; k++)
+    {
+        int count = len - done < IO_CHUNK ? len - done : IO_CHUNK;
+        MPI_File_write_at_all(file, offset + done, buffer + done, count, MPI_CHAR, MPI_STATUS_IGNORE);
+        done += count;
+    }
+    MPI_File_close(&file);
+    counters.bytes += len + (binary && rank == 0 ? sizeof(Header) : 0);
+    free(buffer);
+    return 0;
+}
+
+void display_array(long *array, int size)
+{
+    for(int i = 0; i < size; i++)
+    {
+        printf("%5ld ", array[i]);        
+    }
+    printf("\n");
+}
+
+//-----------------------------------------------------------------
+//--------------------CREATION DE MATRICES-------------------------
+//-----------------------------------------------------------------
+Matrix *generate_matrix(long *data, int h, int w, bool row_opti)
+{
+    //génere une matrice en mémoire avec les données data
+    Matrix *m = (Matrix *) malloc(sizeof(Matrix));
+    m->height=h;
+    m->width=w;
+    m->row_opti=row_opti;
+    m->array = data;
+    return m;
+}
+
+Matrix *create_matrix(int seed, int h, int w, bool row_opti)
+{
+    //créer une matrice avec des valeurs tests
+    Matrix *m = generate_matrix((long *) malloc(h*w*sizeof(long)), h,w,row_opti);
+    int i = seed+1;
+
+    for(int r = 0; r < m->height; r++)
+    {
+        for(int c = 0; c < m->width; c++)
         {
             set(m,r,c,i++);
         }
@@ -396,12 +3991,13 @@ Matrix *create_matrix(int seed, int h, int w, bool row_opti)
     return m;
 }
 
-Matrix *load_matrix(char *path, int numprocs)
+Matrix *load_matrix(char *path)
 {
     FILE * file;
     long val;
-    int size_alloc = 256;
-    int size=0, N, Nlimit;
+    long size_alloc = 256;
+    long size=0;
+    int N;
 
     file = fopen(path, "r");
     if(file==NULL) return NULL;
@@ -414,7 +4010,7 @@ Matrix *load_matrix(char *path, int numprocs)
     {
         if(size == size_alloc)
         {
-            size_alloc=size_alloc*size_alloc;
+            size_alloc=size_alloc*2;
             data = realloc(data, size_alloc*sizeof(long));
         }
         data[size++] = val; 
@@ -422,65 +4018,292 @@ Matrix *load_matrix(char *path, int numprocs)
     fclose(file);
 
     N = sqrt(size);
-    
-    if(N % numprocs != 0) Nlimit = N + numprocs - (N % numprocs);
-    else Nlimit = N;
 
-    //Génere une matrice qui est divisible par le nombre de processeur
-    Matrix *m = generate_matrix( (long *) malloc(Nlimit*Nlimit * sizeof(long)), Nlimit, Nlimit, true);
+    //Génere une matrice de la taille exacte du graphe, la répartition sur les machines n'ajoute rien
+    Matrix *m = generate_matrix( (long *) malloc((long) N*N * sizeof(long)), N, N, true);
 
     
     //Ajoute des valeurs infinie lorsque il yu a un 0 et que celui-ci ne se trouve pas en diagonal
-    //Ajoute des valeurs infinie pour TOUTES les valeur ajouter pour s'adapter au nombre de processeurs
-    #pragma omp parallel for
+    //comme dans load_block une valeur trop grande est ramenée à INF, les valeurs sont gardées en long
+    #pragma omp parallel for schedule(static) proc_bind(close)
     for(int r = 0; r < N; r++)
     {
-        int val;
+        long val;
         for(int c = 0; c <N; c++)
         {
-            val = data[r*N+c];
-            if(val == 0 && r!=c) set(m,r,c,LONG_MAX);
+            val = data[(long) r*N+c];
+            if((val == 0 && r!=c) || val >= INF) set(m,r,c,INF);
             else set(m,r,c,val);
-
-            if(c==N-1)
-            {
-                for(int i = c+1; i < Nlimit; i++)
-                {
-                    set(m,r,i,LONG_MAX);
-                }
-            }
         }
+    }
+
+    free(data);
+    return m;
+}
+
+int adjust(int N, int numprocs)
+{
+    //ajoute des lignes et des colonnes pour que N soit divisible par le nombre de procos
+    //seules les tuiles de la grille en ont besoin, les bandes de lignes ont des parts inégales
+    if(N % numprocs != 0) return N + numprocs - (N % numprocs);
+    return N;
+}
 
-        if(r==N-1)
+
+long *read_updates(char *path, int *count, int transmitter, MPI_Comm comm)
+{
+    int rank, capacity = 64;
+    long *updates = NULL;
+    FILE *file;
+
+    //l'emmeteur lit les triplets u v w jusqu'à la fin du fichier
+    MPI_Comm_rank(comm, &rank);
+    *count = 0;
+    if(rank == transmitter)
+    {
+        updates = (long *) malloc(3*capacity*sizeof(long));
+        file = fopen(path, "r");
+        while(file != NULL && fscanf(file, "%ld %ld %ld", &updates[3 * *count], &updates[3 * *count + 1], &updates[3 * *count + 2]) == 3)
         {
-            for(int i = r+1; i < Nlimit; i++)
-            {
-                for(int c = 0; c <Nlimit; c++)
-                {
-                    set(m,i,c, LONG_MAX);
-                }
-            }
+            if(++*count < capacity) continue;
+            capacity *= 2;
+            updates = (long *) realloc(updates, 3*capacity*sizeof(long));
         }
+        if(file != NULL) fclose(file);
+        else printf("Cannot open %s, no update applied\n", path);
+    }
+
+    //toutes les machines appliquent les memes arcs dans le meme ordre
+    MPI_Bcast(count, 1, MPI_INT, transmitter, comm);
+    if(rank != transmitter) updates = (long *) malloc((3 * *count + 1)*sizeof(long));
+    MPI_Bcast(updates, 3 * *count, MPI_LONG, transmitter, comm);
+    return updates;
+}
+
+int read_header(char *path, Header *header)
+{
+    FILE *file = fopen(path, "rb");
+    if(file == NULL) return 1;
+
+    //un fichier texte n'a pas la signature MAGIC
+    if(fread(header, sizeof(Header), 1, file) != 1 || memcmp(header->magic, MAGIC, 4) != 0)
+    {
+        fclose(file);
+        return 1;
+    }
+    fclose(file);
+
+    //seules les valeurs sur 8 octets sont gérées, relire un tel fichier comme du texte donnerait une matrice fausse
+    if(header->width != sizeof(long))
+    {
+        fprintf(stderr, "%s stores %d-byte values, only %d-byte values are supported... exit\n", path, (int) header->width, (int) sizeof(long));
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    return 0;
+}
+
+int write_binary(Matrix *m, char *path)
+{
+    Header header;
+    FILE *file;
+    long *row;
+    int failed;
+
+    if(m == NULL) return 1;
+    file = fopen(path, "wb");
+    if(file == NULL) return 1;
+
+    //l'entete décrit la matrice puis chaque ligne est convertie dans un tampon et écrite en un seul appel
+    //comme une lecture incomplète dans read_header, une écriture incomplète (disque plein) est une erreur
+    memcpy(header.magic, MAGIC, 4);
+    header.width = sizeof(long);
+    header.size = m->height;
+    header.infinity = LONG_MAX;
+    header.reserved = 0;
+    header.engine = 0;
+    header.checksum = 0;
+    failed = fwrite(&header, sizeof(Header), 1, file) != 1;
+    row = (long *) malloc((m->width > 0 ? m->width : 1)*sizeof(long));
+    for(int r = 0; r < m->height && !failed; r++)
+    {
+        for(int c = 0; c < m->width; c++) row[c] = get(m, r, c) >= INF ? LONG_MAX : get(m, r, c);
+        failed = fwrite(row, sizeof(long), m->width, file) != (size_t) m->width;
+    }
+    free(row);
+    return fclose(file) != 0 || failed;
+}
+
+Matrix *load_block(char *path, Header *header, int row, int column, int height, int width, bool row_opti, MPI_Comm comm)
+{
+    MPI_File file;
+    MPI_Datatype filetype;
+    int N = header->size;
+
+    //partie du bloc présente dans le fichier, le reste correspond à l'ajustement au nombre de procos
+    int h = row + height < N ? height : (N - row > 0 ? N - row : 0);
+    int w = column + width < N ? width : (N - column > 0 ? N - column : 0);
+    long *buffer = (long *) malloc(((long) h*w > 0 ? (long) h*w : 1)*sizeof(long));
+    Matrix *m = generate_matrix((long *) malloc((long) height*width*sizeof(long)), height, width, row_opti);
+
+    //comme dans write_rows chaque lecture est limitée à IO_CHUNK octets, par groupes de lignes du bloc
+    long step = w > 0 && IO_CHUNK / ((long) w*sizeof(long)) > 0 ? IO_CHUNK / ((long) w*sizeof(long)) : 1;
+    long rounds = h > 0 && w > 0 ? (h + step - 1) / step : 0;
+    MPI_Allreduce(MPI_IN_PLACE, &rounds, 1, MPI_LONG, MPI_MAX, comm);
+
+    //chaque machine décrit son bloc comme un sous-tableau du fichier et toutes lisent en meme temps
+    //les lectures successives avancent dans le sous-tableau, une machine qui a fini lit 0 valeur
+    MPI_File_open(comm, path, MPI_MODE_RDONLY, MPI_INFO_NULL, &file);
+    if(h > 0 && w > 0)
+    {
+        int sizes[2] = {N, N}, subsizes[2] = {h, w}, starts[2] = {row, column};
+        MPI_Type_create_subarray(2, sizes, subsizes, starts, MPI_ORDER_C, MPI_LONG, &filetype);
+        MPI_Type_commit(&filetype);
+        MPI_File_set_view(file, sizeof(Header), MPI_LONG, filetype, "native", MPI_INFO_NULL);
+        MPI_Type_free(&filetype);
+    }
+    else MPI_File_set_view(file, sizeof(Header), MPI_LONG, MPI_LONG, "native", MPI_INFO_NULL);
+    for(long k = 0; k < rounds; k++)
+    {
+        long first = k*step, count = first < h ? (h - first < step ? h - first : step) : 0;
+        MPI_File_read_all(file, buffer + (count > 0 ? first*w : 0), (int) (count*w), MPI_LONG, MPI_STATUS_IGNORE);
     }
+    MPI_File_close(&file);
 
+    //range le bloc avec l'optimisation demandée, l'infini du fichier, les valeurs trop grandes et l'ajustement deviennent INF
+    #pragma omp parallel for schedule(static) proc_bind(close)
+    for(int r = 0; r < height; r++)
+    {
+        for(int c = 0; c < width; c++)
+        {
+            long val = r < h && c < w ? buffer[(long) r*w+c] : INF;
+            set(m, r, c, val == header->infinity || val >= INF ? INF : val);
+        }
+    }
+    free(buffer);
     return m;
 }
 
+Arena create_arena(long size)
+{
+    Arena arena;
+    //chaque tampon commence sur une ligne de cache, on prévoit la marge d'alignement
+    arena.size = size + 64;
+    arena.base = (long *) malloc(arena.size*sizeof(long));
+    arena.used = 0;
+    return arena;
+}
+
+long *arena_alloc(Arena *arena, long size)
+{
+    //réserve size valeurs arrondies à 8 valeurs (64 octets), NULL si la zone est pleine
+    long *block = arena->base + arena->used;
+    long rounded = (size + 7) / 8 * 8;
+    if(arena->used + rounded > arena->size) return NULL;
+    arena->used += rounded;
+    return block;
+}
 
-Matrix *copy_matrix(Matrix *m, bool row_opti)
+void free_arena(Arena *arena)
 {
-    Matrix *copy = generate_matrix((long *) malloc(size(m)*sizeof(long)), m->height, m->width, row_opti);
-    
-    //copy chaque valeurs de m dans la nouvelle matrice en respectant l'optimisation de colonne
+    free(arena->base);
+    arena->base = NULL;
+    arena->size = 0;
+    arena->used = 0;
+}
+
+Workspace create_workspace(Matrix *a, Matrix *b, int numprocs)
+{
+    Workspace ws;
+    int h = a->height, w = b->width, part = MAX_PART(numprocs, b->height);
+    long column = (long) b->height*part;
+    long *block;
+
+    //un seul appel à malloc pour tous les tampons utilisés par les itérations
+    //a et b y sont déplacées car leurs tampons sont échangés avec ceux de l'espace de travail
+    //les blocs de b qui circulent et les intersections de redistribute peuvent avoir la plus grande part
+    //les lignes de a sont copiées par le thread qui les calculera, c et spare seront touchés en premier par le noyau
+    //et MPI avec le meme découpage ; b est lue par tous les threads, ses pages sont réparties entre eux
+    ws.arena = create_arena(2*size(a) + 2*column + 2*part*part);
+    block = arena_alloc(&ws.arena, size(a));
+    first_touch(block, a->array, a->height, a->width);
+    free(a->array);
+    a->array = block;
+    block = arena_alloc(&ws.arena, column);
+    first_touch(block, b->array, b->width, b->height);
+    free(b->array);
+    b->array = block;
+    ws.c = generate_matrix(arena_alloc(&ws.arena, size(a)), a->height, a->width, true);
+    ws.spare = generate_matrix(arena_alloc(&ws.arena, column), b->height, b->width, false);
+    ws.out = generate_matrix(arena_alloc(&ws.arena, part*part), h, w, false);
+    ws.in = generate_matrix(arena_alloc(&ws.arena, part*part), h, w, false);
+    return ws;
+}
+
+void first_touch(long *dst, long *src, int rows, long width)
+{
+    int *places = (int *) malloc(omp_get_max_threads()*sizeof(int));
+
+    //meme découpage des lignes entre les places que process, une page appartient au socket du premier thread qui l'écrit
+    #pragma omp parallel proc_bind(close)
+    {
+        int threads = omp_get_num_threads(), s = thread_slot(places);
+        long first = FIRST(s, threads, rows), last = FIRST(s + 1, threads, rows);
+        memcpy(dst + first*width, src + first*width, (last - first)*width*sizeof(long));
+    }
+    free(places);
+}
+
+void free_workspace(Workspace *ws)
+{
+    //libere aussi les tampons de a et b qui ont été déplacés dans la zone
+    free_arena(&ws->arena);
+    free(ws->c);
+    free(ws->spare);
+    free(ws->out);
+    free(ws->in);
+}
+
+Matrix *init_predecessors(Matrix *m, int row, int column)
+{
+    Matrix *pred = generate_matrix((long *) malloc(size(m)*sizeof(long)), m->height, m->width, m->row_opti);
+
+    //un arc (i, j) a pour prédécesseur i, les cases sans arc et la diagonale n'en ont pas
     int limit1 = m->height, limit2 = m->width;
-    #pragma omp parallel for
+    #pragma omp parallel for schedule(static) proc_bind(close)
     for(int r = 0; r < limit1; r++)
     {
         for(int c = 0; c < limit2; c++)
         {
-            set(copy,r,c,get(m,r,c));
+            set(pred, r, c, get(m,r,c) < INF && row + r != column + c ? row + r : -1);
         }
     }
+    return pred;
+}
+
+Paths create_paths(Matrix *a, Matrix *b, int rank, int numprocs)
+{
+    Paths paths;
+
+    //a contient les lignes du bloc rank et b ses colonnes
+    paths.a = init_predecessors(a, FIRST(rank, numprocs, a->width), 0);
+    paths.b = init_predecessors(b, 0, FIRST(rank, numprocs, b->height));
+    paths.ws = create_workspace(paths.a, paths.b, numprocs);
+    return paths;
+}
+
+void free_paths(Paths *paths)
+{
+    free_workspace(&paths->ws);
+    free(paths->a);
+    free(paths->b);
+}
+
+Matrix *copy_matrix(Matrix *m, bool row_opti)
+{
+    Matrix *copy = generate_matrix((long *) malloc(size(m)*sizeof(long)), m->height, m->width, row_opti);
+    
+    //copy chaque valeurs de m dans la nouvelle matrice en respectant l'optimisation de colonne
+    copy_block(m, 0, 0, copy, 0, 0, m->height, m->width);
     return copy;
 }
 
@@ -511,6 +4334,16 @@ int replace_test()
     return 0;
 }
 
+int extract_test()
+{
+    Matrix *a = create_matrix(0,4,4,true);
+    Matrix *b = generate_matrix((long *) malloc(4*sizeof(long)),2,2,false);
+    extract(a,b,1,2);
+    long tab[4] = {7,11,8,12};
+    if(memcmp(tab, b->array, 4*sizeof(long))) return 1;
+    return 0;
+}
+
 int next_previous_test()
 {
     int rank = 0;
@@ -525,44 +4358,78 @@ int next_previous_test()
     return 0;
 }
 
+int partition_test()
+{
+    //les parts couvrent toutes les lignes sans ajout, diffèrent d'au plus une ligne et OWNER retrouve la machine de chaque ligne
+    int counts[4], displs[4];
+    for(int n = 1; n < 12; n++)
+    {
+        partition(n, 4, 1, counts, displs);
+        if(displs[0] != 0 || displs[3] + counts[3] != n) return 1;
+        for(int p = 0; p < 4; p++)
+        {
+            if(counts[p] != PART(p, 4, n) || counts[p] > MAX_PART(4, n) || counts[p] < n / 4) return 1;
+            for(int i = displs[p]; i < displs[p] + counts[p]; i++) if(OWNER(i, 4, n) != p) return 1;
+        }
+    }
+    return 0;
+}
+
 int load_matrix_test()
 {
-    Matrix *m = load_matrix("data/mat_2", 1);
+    Matrix *m = load_matrix("data/mat_2");
     if(m == NULL) return 1;
-    long tab1[16] = {0, 1, 2, LONG_MAX, LONG_MAX, 0, LONG_MAX, 1, LONG_MAX, 3, 0, 6, LONG_MAX, LONG_MAX, LONG_MAX, 0};
+    long tab1[16] = {0, 1, 2, INF, INF, 0, INF, 1, INF, 3, 0, 6, INF, INF, INF, 0};
     if(memcmp(tab1, m->array, 16*sizeof(long))) return 1;
     free(m);
-    m = load_matrix("data/mat_3", 1);
+    m = load_matrix("data/mat_3");
     long tab2[64] = {   
-                        0, 4, 2, LONG_MAX, 6, 9, LONG_MAX, 8, 
-                        6, 0, 2, LONG_MAX, 9, 2, LONG_MAX, 8, 
-                        2, 1, 0, 8, 4, LONG_MAX, 4, 2, 
-                        4, 6, 3, 0, 4, LONG_MAX, 3, 8, 
-                        7, 8, 1, LONG_MAX, 0, 9, 3, LONG_MAX, 
-                        3, 8, 8, 1, 8, 0, LONG_MAX, 7, 
-                        LONG_MAX, 2, 9, 3, 3, 4, 0, 6, 
+                        0, 4, 2, INF, 6, 9, INF, 8, 
+                        6, 0, 2, INF, 9, 2, INF, 8, 
+                        2, 1, 0, 8, 4, INF, 4, 2, 
+                        4, 6, 3, 0, 4, INF, 3, 8, 
+                        7, 8, 1, INF, 0, 9, 3, INF, 
+                        3, 8, 8, 1, 8, 0, INF, 7, 
+                        INF, 2, 9, 3, 3, 4, 0, 6, 
                         6, 4, 5, 2, 3, 1, 7, 0 
                     };
     if(memcmp(tab2, m->array, 64*sizeof(long))) return 1;
     free(m);
-    m = load_matrix("data/mat_1", 4);
-    if(m == NULL) return 1;
-    long tab3[16] = {0, 1, 2, LONG_MAX, 1, 0, LONG_MAX, LONG_MAX, LONG_MAX, 3, 0, LONG_MAX, LONG_MAX, LONG_MAX, LONG_MAX, LONG_MAX};
-    if(memcmp(tab3, m->array, 16*sizeof(long))) return 1;
+    m = load_matrix("data/mat_1");
+    if(m == NULL || m->height != 3) return 1;
+    long tab3[9] = {0, 1, 2, 1, 0, INF, INF, 3, 0};
+    if(memcmp(tab3, m->array, 9*sizeof(long))) return 1;
+    free(m);
+    return 0;
+}
+
+int load_limits_test()
+{
+    //un poids au dela d'un int est gardé, un poids au dela de INF devient l'absence d'arc
+    long expected[9] = {0, 5000000000L, INF, INF, 0, 7, -3, INF, 0};
+    Matrix *m;
+    FILE *file = fopen("data/load_limits_test", "w");
+    if(file == NULL) return 1;
+    fprintf(file, "0 5000000000 9000000000000000000\n%ld 0 7\n-3 0 0\n", INF);
+    fclose(file);
+    m = load_matrix("data/load_limits_test");
+    remove("data/load_limits_test");
+    if(m == NULL || m->height != 3 || memcmp(expected, m->array, 9*sizeof(long))) return 1;
+    free(m->array);
     free(m);
     return 0;
 }
 
 int matrix_process_test()
 {
-    Matrix *m1 = load_matrix("data/mat_2", 1);
+    Matrix *m1 = load_matrix("data/mat_2");
     Matrix *m2 = copy_matrix(m1, false);
     Matrix *m3 = matrix_process(m1,m2);
     long tab[16] = {
                         0, 1, 2, 2,
-                        LONG_MAX,0,LONG_MAX,1,
-                        LONG_MAX,3,0,4,
-                        LONG_MAX,LONG_MAX,LONG_MAX,0
+                        INF,0,INF,1,
+                        INF,3,0,4,
+                        INF,INF,INF,0
                     };
     if(memcmp(tab, m3->array, 16*sizeof(long))) return 1;
     free(m3);
@@ -573,17 +4440,382 @@ int matrix_process_test()
 
 int multi_matrix_process_test()
 {
-    Matrix *m1 = load_matrix("data/mat_3", 1);
+    Matrix *m1 = load_matrix("data/mat_3");
     for(int i = 0; i < 8; i++)
     {
         Matrix *m2 = copy_matrix(m1, false);
         m1 = matrix_process(m1,m2);
     }
-    Matrix *res = load_matrix("data/result_3", 1);
+    Matrix *res = load_matrix("data/result_3");
     if(memcmp(res->array, m1->array, size(res)*sizeof(long))) return 1;
     return 0;
 }
 
+int kernel_test()
+{
+    //chaque noyau supporté doit donner le meme résultat que le noyau sans vectorisation, infinis compris
+    char *names[3] = {"scalar", "avx2", "avx512"};
+    int n = 37, p = 45, m = 23;
+    Matrix *a = create_matrix(0, n, p, true);
+    Matrix *b = create_matrix(7, p, m, false);
+    for(int i = 0; i < n*p; i += 3) a->array[i] = INF;
+    for(int i = 0; i < p*m; i += 5) b->array[i] = INF;
+
+    long *ref = (long *) malloc(n*m*sizeof(long));
+    long *res = (long *) malloc(n*m*sizeof(long));
+    for(int i = 0; i < n*m; i++) ref[i] = INF;
+    minplus_scalar(a->array, b->array, ref, n, p, m, m);
+    for(int k = 0; k < 3; k++)
+    {
+        for(int i = 0; i < n*m; i++) res[i] = INF;
+        select_kernel(names[k])(a->array, b->array, res, n, p, m, m);
+        if(memcmp(ref, res, n*m*sizeof(long))) return 1;
+    }
+    for(int r = 0; r < n; r++)
+    {
+        long min = INF;
+        for(int i = 0; i < p; i++) if(get(a,r,i) + get(b,i,0) < min) min = get(a,r,i) + get(b,i,0);
+        if(ref[r*m] != min) return 1;
+    }
+    return 0;
+}
+
+int binary_test()
+{
+    //la part de lignes de la machine 1 sur 3 doit etre celle lue en texte
+    //une tuile qui dépasse la matrice, comme celles de la grille, est complétée par des infinis
+    //l'écriture sur un disque plein doit échouer
+    Header header;
+    Matrix *m = load_matrix("data/mat_3");
+    if(write_binary(m, "data/binary_test") || !write_binary(m, "/dev/full")) return 1;
+    if(read_header("data/binary_test", &header) || header.size != 8) return 1;
+    Matrix *rows = load_block("data/binary_test", &header, FIRST(1, 3, 8), 0, PART(1, 3, 8), 8, true, MPI_COMM_SELF);
+    Matrix *columns = load_block("data/binary_test", &header, 0, 6, 9, 3, false, MPI_COMM_SELF);
+    remove("data/binary_test");
+    if(rows->height != 3) return 1;
+    for(int r = 0; r < 9; r++)
+    {
+        for(int c = 0; c < 3; c++)
+        {
+            if(r < 8 && get(rows, c, r) != get(m, c + FIRST(1, 3, 8), r)) return 1;
+            if(get(columns, r, c) != (r < 8 && c + 6 < 8 ? get(m, r, c+6) : INF)) return 1;
+        }
+    }
+    return 0;
+}
+
+int checksum_test()
+{
+    //la somme de controle ne dépend pas du découpage en lignes mais change avec une seule valeur ou sa place
+    Matrix *m = load_matrix("data/mat_13");
+    Matrix *top = generate_matrix(m->array, 5, 13, true), *bottom = generate_matrix(m->array + 5*13, 8, 13, true);
+    uint64_t whole = checksum(m, 0, MPI_COMM_SELF);
+    long t;
+
+    if(checksum(top, 0, MPI_COMM_SELF) + checksum(bottom, 5, MPI_COMM_SELF) != whole) return 1;
+    m->array[20]++;
+    if(checksum(m, 0, MPI_COMM_SELF) == whole) return 1;
+    m->array[20]--;
+    t = m->array[1];
+    m->array[1] = m->array[2];
+    m->array[2] = t;
+    return checksum(m, 0, MPI_COMM_SELF) == whole;
+}
+
+int write_rows_test()
+{
+    //le fichier écrit doit contenir le texte affiché par display_matrix
+    char expected[512], written[512];
+    int len = 0;
+    FILE *file;
+    Matrix *m = load_matrix("data/mat_3");
+    for(int r = 0; r < 8; r++)
+    {
+        for(int c = 0; c < 8; c++)
+        {
+            if(get(m,r,c) == INF) len += sprintf(expected + len, "%c ", 'i');
+            else len += sprintf(expected + len, "%ld ", get(m,r,c));
+        }
+        len += sprintf(expected + len, "\n");
+    }
+    if(write_rows("data/write_rows_test", m, 0, 8, false, MPI_COMM_SELF)) return 1;
+    file = fopen("data/write_rows_test", "r");
+    if(file == NULL) return 1;
+    if((int) fread(written, 1, sizeof(written), file) != len) return 1;
+    fclose(file);
+    remove("data/write_rows_test");
+    if(memcmp(expected, written, len)) return 1;
+    return 0;
+}
+
+int compact_test()
+{
+    //les noyaux compacts doivent donner le meme produit que le noyau long, infinis compris
+    int n = 37, p = 45, m = 23;
+    Matrix *a = create_matrix(0, n, p, true);
+    Matrix *b = create_matrix(7, p, m, false);
+    long *ref = (long *) malloc(n*m*sizeof(long)), *res = (long *) malloc(n*m*sizeof(long));
+    int32_t *a32 = (int32_t *) malloc(n*p*sizeof(int32_t)), *b32 = (int32_t *) malloc(p*m*sizeof(int32_t)), *c32 = (int32_t *) malloc(n*m*sizeof(int32_t));
+    uint16_t *a16 = (uint16_t *) malloc(n*p*sizeof(uint16_t)), *b16 = (uint16_t *) malloc(p*m*sizeof(uint16_t)), *c16 = (uint16_t *) malloc(n*m*sizeof(uint16_t));
+
+    for(int i = 0; i < n*p; i += 3) a->array[i] = INF;
+    for(int i = 0; i < p*m; i += 5) b->array[i] = INF;
+    minplus_store(a->array, b->array, ref, n, p, m, m);
+
+    pack_int32(a->array, a32, n*p);
+    pack_int32(b->array, b32, p*m);
+    minplus_store_int32(a32, b32, c32, n, p, m, m);
+    unpack_int32(c32, res, n*m);
+    if(memcmp(ref, res, n*m*sizeof(long))) return 1;
+
+    pack_uint16(a->array, a16, n*p);
+    pack_uint16(b->array, b16, p*m);
+    minplus_store_uint16(a16, b16, c16, n, p, m, m);
+    unpack_uint16(c16, res, n*m);
+    if(memcmp(ref, res, n*m*sizeof(long))) return 1;
+
+    free(a32); free(b32); free(c32);
+    free(a16); free(b16); free(c16);
+    free(ref); free(res);
+    return 0;
+}
+
+int negative_test()
+{
+    //arc 0 -> 1 de poids -5 et aucun chemin vers 2 : l'infini plus -5 doit rester infini avec chaque noyau et chaque moteur long
+    char *names[3] = {"scalar", "avx2", "avx512"};
+    long i = INF;
+    long data[9] = {0, -5, i,  i, 0, i,  2, i, 0}, expected[9] = {0, -5, i,  i, 0, i,  2, -3, 0};
+    Kernel kernel = minplus;
+    Matrix *m = generate_matrix(data, 3, 3, true), *r, *pred, *next;
+    bool failed = false;
+
+    for(int k = 0; k < 3; k++)
+    {
+        minplus = select_kernel(names[k]);
+        r = matrix_process(m, m);
+        r = matrix_process(r, r);
+        failed = failed || memcmp(r->array, expected, 9*sizeof(long));
+    }
+    minplus = kernel;
+    if(failed) return 1;
+
+    r = copy_matrix(m, true);
+    floyd_shared(r, ELEMENT_LONG);
+    if(memcmp(r->array, expected, 9*sizeof(long))) return 1;
+    r = copy_matrix(m, true);
+    floyd_diagonal(r);
+    if(memcmp(r->array, expected, 9*sizeof(long))) return 1;
+
+    //une case sans chemin n'a pas de prédécesseur
+    pred = init_predecessors(m, 0, 0);
+    r = matrix_process_path(m, m, pred, pred, 0, &next);
+    if(memcmp(r->array, expected, 9*sizeof(long)) || get(next, 0, 2) != -1) return 1;
+    return 0;
+}
+
+int element_test()
+{
+    //un type imposé trop petit pour les poids est remplacé par long, sinon il est gardé meme si un plus petit suffit
+    long i = INF;
+    long negative[9] = {0, -5, i,  i, 0, i,  2, i, 0}, expected[9] = {0, -5, i,  i, 0, i,  2, -3, 0};
+    long heavy[9] = {0, 40000, i,  i, 0, 40000,  i, i, 0};
+    Matrix *m = generate_matrix(negative, 3, 3, true), *h = generate_matrix(heavy, 3, 3, true);
+
+    if(select_element(m, 3, ELEMENT_UINT16, MPI_COMM_SELF) != ELEMENT_LONG || select_element(m, 3, ELEMENT_INT32, MPI_COMM_SELF) != ELEMENT_LONG) return 1;
+    if(select_element(h, 3, ELEMENT_UINT16, MPI_COMM_SELF) != ELEMENT_LONG || select_element(h, 3, ELEMENT_INT32, MPI_COMM_SELF) != ELEMENT_INT32) return 1;
+    if(select_element(h, 3, ELEMENT_AUTO, MPI_COMM_SELF) != ELEMENT_INT32) return 1;
+
+    //le calcul demandé en uint16 reste alors exact
+    floyd_shared(m, ELEMENT_UINT16);
+    floyd_shared(h, ELEMENT_UINT16);
+    return memcmp(m->array, expected, 9*sizeof(long)) || get(h, 0, 2) != 80000;
+}
+
+int path_test()
+{
+    //chaine 0 -> 1 -> 2 -> 3 de poids 1 et raccourci 0 -> 3 de poids 10, le carré converge en deux itérations
+    long i = INF;
+    long data[16] = {0, 1, i, 10,  i, 0, 1, i,  i, i, 0, 1,  i, i, i, 0};
+    long *array = (long *) malloc(16*sizeof(long));
+    int nodes[4], expected[4] = {0, 1, 2, 3};
+    Matrix *m, *pred, *next;
+
+    memcpy(array, data, 16*sizeof(long));
+    m = generate_matrix(array, 4, 4, true);
+    pred = init_predecessors(m, 0, 0);
+    for(int k = 0; k < 2; k++)
+    {
+        m = matrix_process_path(m, m, pred, pred, 0, &next);
+        pred = next;
+    }
+
+    if(get(m, 0, 3) != 3) return 1;
+    if(path(pred->array, 4, 0, 3, nodes) != 4 || memcmp(nodes, expected, 4*sizeof(int))) return 1;
+    if(path(pred->array + 12, 4, 3, 0, nodes) != 0) return 1;
+    if(path(pred->array + 8, 4, 2, 2, nodes) != 1 || nodes[0] != 2) return 1;
+    return 0;
+}
+
+int update_test()
+{
+    //ajoute l'arc 0 -> 7 de poids 1 aux distances de mat_3 et compare avec un calcul complet du graphe modifié
+    long updates[3] = {0, 7, 1};
+    Matrix *d = load_matrix("data/result_3");
+    Matrix *m1 = load_matrix("data/mat_3");
+    set(m1, 0, 7, 1);
+    for(int i = 0; i < 8; i++)
+    {
+        Matrix *m2 = copy_matrix(m1, false);
+        m1 = matrix_process(m1,m2);
+    }
+
+    if(apply_updates(d, NULL, updates, 1, MPI_COMM_SELF) != 0) return 1;
+    if(memcmp(d->array, m1->array, size(d)*sizeof(long))) return 1;
+    return 0;
+}
+
+int sparse_test()
+{
+    //Dijkstra depuis chaque sommet de mat_3, lu directement ou depuis la matrice dense, doit donner result_3
+    Graph *g = load_graph("data/mat_3");
+    Matrix *m = load_matrix("data/mat_3");
+    Graph *h = graph_from_rows(m, MPI_COMM_SELF);
+    Matrix *res = load_matrix("data/result_3");
+    Matrix *a = sparse(g, 0, 1);
+    Matrix *b = sparse(h, 0, 1);
+
+    if(g->n != 8 || g->edges != h->edges) return 1;
+    if(memcmp(res->array, a->array, size(res)*sizeof(long))) return 1;
+    if(memcmp(res->array, b->array, size(res)*sizeof(long))) return 1;
+    return 0;
+}
+
+int floyd_test()
+{
+    Matrix *m = load_matrix("data/mat_3");
+    floyd_diagonal(m);
+    Matrix *res = load_matrix("data/result_3");
+    if(memcmp(res->array, m->array, size(res)*sizeof(long))) return 1;
+    return 0;
+}
+
+int generate_test()
+{
+    //un graphe dense a tous ses arcs avec des poids de 1 à 100, la meme graine redonne le meme graphe
+    //une grille de 3x3 a 12 aretes dans les deux sens, une densité nulle ne donne aucun arc
+    long edges;
+    Matrix *d = generate_graph(GENERATOR_DENSE, 5, 0, 3, &edges);
+    Matrix *e = generate_graph(GENERATOR_DENSE, 5, 0, 3, &edges);
+    if(edges != 20 || !equals(d, e)) return 1;
+    for(int r = 0; r < 5; r++)
+    {
+        for(int c = 0; c < 5; c++) if(r == c ? get(d,r,c) != 0 : get(d,r,c) < 1 || get(d,r,c) > 100) return 1;
+    }
+    generate_graph(GENERATOR_GRID, 9, 0, 3, &edges);
+    if(edges != 24) return 1;
+    generate_graph(GENERATOR_ER, 9, 0, 3, &edges);
+    if(edges != 0) return 1;
+    return 0;
+}
+
+int summa_test()
+{
+    //sur une grille d'une seule machine le produit SUMMA doit etre celui de matrix_process et ses carrés le résultat attendu
+    Grid grid = create_grid(MPI_COMM_SELF);
+    Matrix *m = load_matrix("data/mat_13"), *res = load_matrix("data/result_13");
+    Matrix *c = generate_matrix((long *) malloc(size(m)*sizeof(long)), 13, 13, true);
+    if(!equals(summa_process(m, m, c, &grid), matrix_process(m, m))) return 1;
+    summa(m, 13, &grid);
+    return !equals(m, res);
+}
+
+int shared_test()
+{
+    //Floyd-Warshall par bandes avec une derniere bande plus étroite, en long et dans les types compacts
+    int elements[3] = {ELEMENT_LONG, ELEMENT_INT32, ELEMENT_UINT16};
+    Matrix *res = load_matrix("data/result_100");
+    for(int e = 0; e < 3; e++)
+    {
+        Matrix *m = load_matrix("data/mat_100");
+        floyd_shared(m, elements[e]);
+        if(!equals(m, res)) return 1;
+    }
+    return 0;
+}
+
+int manifest_test()
+{
+    //les graphes sont triés du plus gros au plus petit, un fichier absent est gardé en dernier et le résultat par défaut est <data>.out
+    int count;
+    Entry *entries;
+    FILE *file = fopen("data/manifest_test", "w");
+    if(file == NULL) return 1;
+    fprintf(file, "# test\ndata/mat_3 data/r3\n\ndata/missing data/r0\ndata/mat_100 data/r100\n  data/mat_13\n");
+    fclose(file);
+    entries = read_manifest("data/manifest_test", &count);
+    remove("data/manifest_test");
+    if(count != 4) return 1;
+    if(strcmp(entries[0].data, "data/mat_100") || strcmp(entries[1].output, "data/mat_13.out") || strcmp(entries[2].output, "data/r3")) return 1;
+    if(strcmp(entries[3].data, "data/missing") || entries[3].bytes != 0) return 1;
+    free(entries);
+    return 0;
+}
+
+int reach_test()
+{
+    //Warshall et les carrés dans un anneau d'une machine donnent 1 exactement là où le résultat est fini
+    int words = WORDS(100);
+    Matrix *m = load_matrix("data/mat_100"), *res = load_matrix("data/result_100"), *r;
+    uint64_t *a = pack_bits(m), *w = pack_bits(m), *b = (uint64_t *) malloc(100*words*sizeof(uint64_t));
+    uint64_t *c = (uint64_t *) malloc(100*words*sizeof(uint64_t)), *spare = (uint64_t *) malloc(100*words*sizeof(uint64_t)), *tmp;
+    uint64_t ones[2] = {~(uint64_t) 0, ~(uint64_t) 0}, outside[2] = {(uint64_t) 1 << 5, (uint64_t) 1 << 9}, rows[6] = {1, 2, 4, 8, 16, 32}, sum[2] = {0, 0};
+
+    warshall(w, 100);
+    r = unpack_bits(w, 100, 100);
+    for(int i = 0; i < 100*100; i++) if(r->array[i] != (res->array[i] < INF)) return 1;
+    for(int k = 0; k < 7; k++)
+    {
+        memcpy(b, a, 100*words*sizeof(uint64_t));
+        process_bits(a, &b, c, &spare, 100, 0, 1);
+        tmp = a;
+        a = c;
+        c = tmp;
+    }
+    if(memcmp(a, w, 100*words*sizeof(uint64_t))) return 1;
+
+    //les lignes 70 à 72 de b sont ajoutées par les bits 70 à 72 de a, qui sont dans le second mot
+    or_rows(ones, rows, 70, 3, sum, 2);
+    if(sum[0] != (1|4|16) || sum[1] != (2|8|32)) return 1;
+    or_rows(outside, rows, 70, 3, sum + 1, 1);
+    if(sum[1] != (2|8|32)) return 1;
+    free(a);
+    free(b);
+    free(c);
+    free(spare);
+    free(w);
+    return 0;
+}
+
+int copy_block_test()
+{
+    //la copie par tuiles doit donner les memes valeurs que get dans les deux sens, avec des tailles qui ne sont pas multiples des tuiles
+    Matrix *m = create_matrix(0, 45, 70, true);
+    Matrix *t = copy_matrix(m, false), *back = copy_matrix(t, true);
+    Matrix *b = generate_matrix((long *) malloc(37*33*sizeof(long)), 37, 33, false);
+    if(!equals(m, back)) return 1;
+    extract(m, b, 5, 20);
+    for(int r = 0; r < 45; r++)
+    {
+        for(int c = 0; c < 70; c++) if(get(t,r,c) != get(m,r,c)) return 1;
+    }
+    for(int r = 0; r < 37; r++)
+    {
+        for(int c = 0; c < 33; c++) if(get(b,r,c) != get(m,r+5,c+20)) return 1;
+    }
+    return 0;
+}
+
 int run_test(char *test_name, int (*test_fnct)(), int id)
 {
     if(test_fnct()) 
@@ -604,10 +4836,30 @@ int test(int rank, int numprocs)
     if(rank==TRANSMITTER)
     {
         nb_failed+=run_test("replace", replace_test, ++id);
+        nb_failed+=run_test("extract", extract_test, ++id);
         nb_failed+=run_test("next_previous", next_previous_test, ++id);
+        nb_failed+=run_test("partition", partition_test, ++id);
         nb_failed+=run_test("load_matrix", load_matrix_test, ++id);
+        nb_failed+=run_test("load_limits", load_limits_test, ++id);
         nb_failed+=run_test("matrix_process", matrix_process_test, ++id);
         nb_failed+=run_test("multi_matrix_process", multi_matrix_process_test, ++id);
+        nb_failed+=run_test("kernel", kernel_test, ++id);
+        nb_failed+=run_test("binary", binary_test, ++id);
+        nb_failed+=run_test("write_rows", write_rows_test, ++id);
+        nb_failed+=run_test("checksum", checksum_test, ++id);
+        nb_failed+=run_test("compact", compact_test, ++id);
+        nb_failed+=run_test("element", element_test, ++id);
+        nb_failed+=run_test("path", path_test, ++id);
+        nb_failed+=run_test("negative", negative_test, ++id);
+        nb_failed+=run_test("update", update_test, ++id);
+        nb_failed+=run_test("sparse", sparse_test, ++id);
+        nb_failed+=run_test("floyd", floyd_test, ++id);
+        nb_failed+=run_test("generate", generate_test, ++id);
+        nb_failed+=run_test("copy_block", copy_block_test, ++id);
+        nb_failed+=run_test("summa", summa_test, ++id);
+        nb_failed+=run_test("shared", shared_test, ++id);
+        nb_failed+=run_test("manifest", manifest_test, ++id);
+        nb_failed+=run_test("reach", reach_test, ++id);
         printf("%d test failed.\n", nb_failed);
     }
     return 0;